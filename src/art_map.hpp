@@ -0,0 +1,974 @@
+#ifndef SJTU_ART_MAP_HPP
+#define SJTU_ART_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "node_pool.hpp"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sjtu {
+    // how art_map reads a key as bytes: Encode gives a form that compares
+    // like the key and Byte(e, d) its d-th byte, -1 once the key has ended.
+    // An integer is its big-endian bytes with the sign bit flipped
+    template<class Key, bool = std::is_integral<Key>::value && !std::is_same<Key, bool>::value>
+    struct art_key {
+        static_assert(std::is_same<Key, std::string>::value, "art_map needs integer or std::string keys");
+    };
+
+    template<class Key>
+    struct art_key<Key, true> {
+        static_assert(sizeof(Key) <= 8, "art_map keys are at most 64 bits");
+
+        typedef uint64_t Bytes;
+
+        static const bool VARIABLE = false;
+
+        static Bytes Encode(Key key) {
+            typedef typename std::make_unsigned<Key>::type Bits;
+            uint64_t e = (Bits)key;
+            if (std::is_signed<Key>::value)
+                e ^= (uint64_t)1 << (8 * sizeof(Key) - 1);
+            return e;
+        }
+
+        static int Byte(Bytes e, size_t d) {
+            return (e >> (8 * (sizeof(Key) - 1 - d))) & 0xff;
+        }
+    };
+
+    // a string is its own bytes, which std::string orders as unsigned
+    // char, so any byte (zero too) may appear and one key may be a prefix
+    // of another
+    template<>
+    struct art_key<std::string, false> {
+        typedef std::string_view Bytes;
+
+        static const bool VARIABLE = true;
+
+        static Bytes Encode(const std::string &key) {
+            return key;
+        }
+
+        static int Byte(Bytes e, size_t d) {
+            return d < e.size() ? (unsigned char)e[d] : -1;
+        }
+    };
+
+    // ordered map over integer or byte-string keys on an adaptive radix
+    // tree: art_key reads a key as bytes, inner nodes branch on one byte
+    // and come in four sizes (4, 16, 48, 256 children) that grow and shrink
+    // with their fan-out, and a node keeps the bytes its whole subtree
+    // shares as a prefix so single-child chains never appear. Only the
+    // first MAX_PREFIX of those bytes are stored, a longer prefix (strings
+    // only) is checked against the key of a leaf below it; a string that
+    // ends where a node branches hangs from the node's end slot. The leaves
+    // are chained in key order, which is what iterators walk
+    template<class Key, class Value>
+    class art_map {
+    public:
+        typedef pair<const Key, Value> value_type;
+
+    private:
+        typedef art_key<Key> Traits;
+        typedef typename Traits::Bytes Bytes;
+
+        static const size_t MAX_PREFIX = 8;
+
+        // a child reference, leaves are tagged with the low bit
+        typedef uintptr_t Ref;
+
+        class Leaf {
+        public:
+            Leaf *prev, *next;
+            alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+            value_type *Package() {
+                return reinterpret_cast<value_type *>(storage);
+            }
+
+            const value_type *Package() const {
+                return reinterpret_cast<const value_type *>(storage);
+            }
+        };
+
+        enum Type {NODE4, NODE16, NODE48, NODE256};
+
+        struct FixedInner {
+            uint8_t type;
+            uint8_t prefix_len;
+            uint16_t count;
+            uint8_t prefix[MAX_PREFIX];
+        };
+
+        // count is of the byte children, end is not among them
+        struct TextInner {
+            uint8_t type;
+            uint16_t count;
+            uint32_t prefix_len;
+            uint8_t prefix[MAX_PREFIX];
+            Ref end;
+        };
+
+        typedef typename std::conditional<Traits::VARIABLE, TextInner, FixedInner>::type Inner;
+
+        struct Node4 : Inner {
+            uint8_t keys[4];
+            Ref children[4];
+        };
+
+        struct Node16 : Inner {
+            uint8_t keys[16];
+            Ref children[16];
+        };
+
+        // index holds slot + 1 for each byte, 0 where there is no child
+        struct Node48 : Inner {
+            uint8_t index[256];
+            Ref children[48];
+        };
+
+        struct Node256 : Inner {
+            Ref children[256];
+        };
+
+        typedef std::allocator<value_type> Allocator;
+
+        node_pool<Leaf, Allocator> leaves;
+        node_pool<Node4, Allocator> pool4;
+        node_pool<Node16, Allocator> pool16;
+        node_pool<Node48, Allocator> pool48;
+        node_pool<Node256, Allocator> pool256;
+        Ref root;
+        Leaf header; // end(), the list of leaves is a ring through it
+        size_t n;
+
+        static Bytes Encode(const Key &key) {
+            return Traits::Encode(key);
+        }
+
+        static int Byte(Bytes e, size_t d) {
+            return Traits::Byte(e, d);
+        }
+
+        static bool IsLeaf(Ref r) {
+            return r & 1;
+        }
+
+        static Leaf *AsLeaf(Ref r) {
+            return reinterpret_cast<Leaf *>(r & ~(Ref)1);
+        }
+
+        static Inner *AsInner(Ref r) {
+            return reinterpret_cast<Inner *>(r);
+        }
+
+        static Ref LeafRef(Leaf *l) {
+            return reinterpret_cast<Ref>(l) | 1;
+        }
+
+        static Ref InnerRef(Inner *x) {
+            return reinterpret_cast<Ref>(x);
+        }
+
+        static Bytes EncodeLeaf(const Leaf *l) {
+            return Encode(l->Package()->first);
+        }
+
+        // where a key that ends at x hangs, null for integer keys
+        static Ref *EndOf(const FixedInner *) {
+            return nullptr;
+        }
+
+        static Ref *EndOf(const TextInner *x) {
+            return const_cast<Ref *>(&x->end);
+        }
+
+        static size_t Stored(const Inner *x) {
+            return x->prefix_len < MAX_PREFIX ? x->prefix_len : MAX_PREFIX;
+        }
+
+        // how many bytes of the prefix of r, which sits at depth d, e
+        // matches; past the stored ones they are read off a leaf below
+        static size_t Mismatch(Ref r, Bytes e, size_t d) {
+            const Inner *x = AsInner(r);
+            size_t i = 0, stored = Stored(x);
+            while (i < stored && x->prefix[i] == Byte(e, d + i))
+                ++i;
+            if (i < stored || i == x->prefix_len)
+                return i;
+            Bytes f = EncodeLeaf(Minimum(r));
+            while (i < x->prefix_len && Byte(f, d + i) == Byte(e, d + i))
+                ++i;
+            return i;
+        }
+
+        // byte i of the prefix of r, which sits at depth d
+        static int PrefixByte(Ref r, size_t d, size_t i) {
+            return i < MAX_PREFIX ? AsInner(r)->prefix[i] : Byte(EncodeLeaf(Minimum(r)), d + i);
+        }
+
+        template<class Node>
+        Node *NewInner(node_pool<Node, Allocator> &pool, Type type, size_t hint) {
+            Node *x = new (pool.allocate(hint)) Node();
+            x->type = type;
+            return x;
+        }
+
+        void FreeInner(Inner *x) {
+            switch (x->type) {
+                case NODE4: pool4.deallocate(static_cast<Node4 *>(x)); break;
+                case NODE16: pool16.deallocate(static_cast<Node16 *>(x)); break;
+                case NODE48: pool48.deallocate(static_cast<Node48 *>(x)); break;
+                default: pool256.deallocate(static_cast<Node256 *>(x)); break;
+            }
+        }
+
+        static void CopyHeader(Inner *dst, const Inner *src) {
+            dst->prefix_len = src->prefix_len;
+            dst->count = src->count;
+            for (size_t i = 0; i < Stored(src); ++i)
+                dst->prefix[i] = src->prefix[i];
+            if (EndOf(src))
+                *EndOf(dst) = *EndOf(src);
+        }
+
+        Leaf *NewLeaf(const Key &key, const Value &value) {
+            Leaf *l = leaves.allocate(n);
+            try {
+                new (l->storage) value_type(key, value);
+            }
+            catch (...) {
+                leaves.deallocate(l);
+                throw;
+            }
+            return l;
+        }
+
+        // b = -1 asks for the end slot
+        static Ref *FindChild(Inner *x, int b) {
+            if (b < 0) {
+                Ref *end = EndOf(x);
+                return end && *end ? end : nullptr;
+            }
+            switch (x->type) {
+                case NODE4: {
+                    Node4 *y = static_cast<Node4 *>(x);
+                    for (int i = 0; i < y->count; ++i)
+                        if (y->keys[i] == b)
+                            return y->children + i;
+                    return nullptr;
+                }
+                case NODE16: {
+                    Node16 *y = static_cast<Node16 *>(x);
+#if defined(__SSE2__)
+                    __m128i hit = _mm_cmpeq_epi8(_mm_set1_epi8((char)b),
+                                                 _mm_loadu_si128(reinterpret_cast<const __m128i *>(y->keys)));
+                    int mask = _mm_movemask_epi8(hit) & ((1 << y->count) - 1);
+                    return mask ? y->children + __builtin_ctz(mask) : nullptr;
+#else
+                    for (int i = 0; i < y->count; ++i)
+                        if (y->keys[i] == b)
+                            return y->children + i;
+                    return nullptr;
+#endif
+                }
+                case NODE48: {
+                    Node48 *y = static_cast<Node48 *>(x);
+                    return y->index[b] ? y->children + y->index[b] - 1 : nullptr;
+                }
+                default: {
+                    Node256 *y = static_cast<Node256 *>(x);
+                    return y->children[b] ? y->children + b : nullptr;
+                }
+            }
+        }
+
+        // the child with the smallest byte above b (b = -1 for the first)
+        static Ref NextChild(const Inner *x, int b) {
+            switch (x->type) {
+                case NODE4: {
+                    const Node4 *y = static_cast<const Node4 *>(x);
+                    for (int i = 0; i < y->count; ++i)
+                        if (y->keys[i] > b)
+                            return y->children[i];
+                    return 0;
+                }
+                case NODE16: {
+                    const Node16 *y = static_cast<const Node16 *>(x);
+                    for (int i = 0; i < y->count; ++i)
+                        if (y->keys[i] > b)
+                            return y->children[i];
+                    return 0;
+                }
+                case NODE48: {
+                    const Node48 *y = static_cast<const Node48 *>(x);
+                    for (int i = b + 1; i < 256; ++i)
+                        if (y->index[i])
+                            return y->children[y->index[i] - 1];
+                    return 0;
+                }
+                default: {
+                    const Node256 *y = static_cast<const Node256 *>(x);
+                    for (int i = b + 1; i < 256; ++i)
+                        if (y->children[i])
+                            return y->children[i];
+                    return 0;
+                }
+            }
+        }
+
+        // a key ending at x comes before all of its children
+        static Leaf *Minimum(Ref r) {
+            while (!IsLeaf(r)) {
+                Inner *x = AsInner(r);
+                r = EndOf(x) && *EndOf(x) ? *EndOf(x) : NextChild(x, -1);
+            }
+            return AsLeaf(r);
+        }
+
+        // the first leaf at or above e (strictly above when above) in the
+        // subtree r, whose keys agree with e on the first d bytes; the
+        // recursion is at most one level per byte of e, plus one
+        static Leaf *LowerBound(Ref r, size_t d, Bytes e, bool above) {
+            if (IsLeaf(r)) {
+                Bytes f = EncodeLeaf(AsLeaf(r));
+                return (above ? e < f : !(f < e)) ? AsLeaf(r) : nullptr;
+            }
+            Inner *x = AsInner(r);
+            size_t i = Mismatch(r, e, d);
+            if (i < x->prefix_len)
+                return PrefixByte(r, d, i) > Byte(e, d + i) ? Minimum(r) : nullptr;
+            d += x->prefix_len;
+            int b = Byte(e, d);
+            Ref *child = FindChild(x, b);
+            if (child) {
+                Leaf *res = LowerBound(*child, d + 1, e, above);
+                if (res)
+                    return res;
+            }
+            Ref next = NextChild(x, b);
+            return next ? Minimum(next) : nullptr;
+        }
+
+        // puts l into the ring right before the first leaf above it
+        void Link(Leaf *l, Bytes e) {
+            Leaf *next = LowerBound(root, 0, e, true);
+            if (!next)
+                next = &header;
+            l->next = next;
+            l->prev = next->prev;
+            next->prev->next = l;
+            next->prev = l;
+        }
+
+        void AddChild(Ref *slot, Inner *x, int b, Ref child) {
+            if (b < 0) {
+                *EndOf(x) = child;
+                return;
+            }
+            switch (x->type) {
+                case NODE4: {
+                    Node4 *y = static_cast<Node4 *>(x);
+                    if (y->count == 4) {
+                        Node16 *z = NewInner(pool16, NODE16, n >> 3);
+                        CopyHeader(z, y);
+                        for (int i = 0; i < 4; ++i) {
+                            z->keys[i] = y->keys[i];
+                            z->children[i] = y->children[i];
+                        }
+                        *slot = InnerRef(z);
+                        pool4.deallocate(y);
+                        AddChild(slot, z, b, child);
+                        return;
+                    }
+                    int i = y->count;
+                    for (; i && y->keys[i - 1] > b; --i) {
+                        y->keys[i] = y->keys[i - 1];
+                        y->children[i] = y->children[i - 1];
+                    }
+                    y->keys[i] = b;
+                    y->children[i] = child;
+                    ++y->count;
+                    return;
+                }
+                case NODE16: {
+                    Node16 *y = static_cast<Node16 *>(x);
+                    if (y->count == 16) {
+                        Node48 *z = NewInner(pool48, NODE48, n >> 5);
+                        CopyHeader(z, y);
+                        for (int i = 0; i < 16; ++i) {
+                            z->index[y->keys[i]] = i + 1;
+                            z->children[i] = y->children[i];
+                        }
+                        *slot = InnerRef(z);
+                        pool16.deallocate(y);
+                        AddChild(slot, z, b, child);
+                        return;
+                    }
+                    int i = y->count;
+                    for (; i && y->keys[i - 1] > b; --i) {
+                        y->keys[i] = y->keys[i - 1];
+                        y->children[i] = y->children[i - 1];
+                    }
+                    y->keys[i] = b;
+                    y->children[i] = child;
+                    ++y->count;
+                    return;
+                }
+                case NODE48: {
+                    Node48 *y = static_cast<Node48 *>(x);
+                    if (y->count == 48) {
+                        Node256 *z = NewInner(pool256, NODE256, n >> 8);
+                        CopyHeader(z, y);
+                        for (int i = 0; i < 256; ++i)
+                            if (y->index[i])
+                                z->children[i] = y->children[y->index[i] - 1];
+                        *slot = InnerRef(z);
+                        pool48.deallocate(y);
+                        AddChild(slot, z, b, child);
+                        return;
+                    }
+                    int i = 0;
+                    while (y->children[i])
+                        ++i;
+                    y->children[i] = child;
+                    y->index[b] = i + 1;
+                    ++y->count;
+                    return;
+                }
+                default: {
+                    Node256 *y = static_cast<Node256 *>(x);
+                    y->children[b] = child;
+                    ++y->count;
+                    return;
+                }
+            }
+        }
+
+        // drops byte b (the end slot when b = -1) from x, which *slot
+        // refers to, and shrinks x when it gets sparse; a Node4 left with
+        // one child merges into it. The smaller node is allocated before x
+        // changes, so if that throws the tree is as it was
+        void RemoveChild(Ref *slot, Inner *x, int b) {
+            if (b < 0) {
+                *EndOf(x) = 0;
+                if (x->type != NODE4)
+                    return;
+            }
+            switch (x->type) {
+                case NODE4: {
+                    Node4 *y = static_cast<Node4 *>(x);
+                    if (b >= 0) {
+                        int i = 0;
+                        while (y->keys[i] != b)
+                            ++i;
+                        for (--y->count; i < y->count; ++i) {
+                            y->keys[i] = y->keys[i + 1];
+                            y->children[i] = y->children[i + 1];
+                        }
+                    }
+                    Ref end = EndOf(y) ? *EndOf(y) : 0;
+                    if (y->count + (end != 0) > 1)
+                        return;
+                    Ref child = end ? end : y->children[0];
+                    if (!IsLeaf(child)) {
+                        // z's prefix becomes y's, the byte between and its own
+                        Inner *z = AsInner(child);
+                        uint8_t prefix[MAX_PREFIX];
+                        size_t len = 0;
+                        for (size_t j = 0; j < Stored(y); ++j)
+                            prefix[len++] = y->prefix[j];
+                        if (len < MAX_PREFIX)
+                            prefix[len++] = y->keys[0];
+                        for (size_t j = 0; j < Stored(z) && len < MAX_PREFIX; ++j)
+                            prefix[len++] = z->prefix[j];
+                        for (size_t j = 0; j < len; ++j)
+                            z->prefix[j] = prefix[j];
+                        z->prefix_len = y->prefix_len + 1 + z->prefix_len;
+                    }
+                    *slot = child;
+                    pool4.deallocate(y);
+                    return;
+                }
+                case NODE16: {
+                    Node16 *y = static_cast<Node16 *>(x);
+                    Node4 *z = y->count - 1 > 3 ? nullptr : NewInner(pool4, NODE4, n >> 1);
+                    int i = 0;
+                    while (y->keys[i] != b)
+                        ++i;
+                    for (--y->count; i < y->count; ++i) {
+                        y->keys[i] = y->keys[i + 1];
+                        y->children[i] = y->children[i + 1];
+                    }
+                    if (!z)
+                        return;
+                    CopyHeader(z, y);
+                    for (int j = 0; j < y->count; ++j) {
+                        z->keys[j] = y->keys[j];
+                        z->children[j] = y->children[j];
+                    }
+                    *slot = InnerRef(z);
+                    pool16.deallocate(y);
+                    return;
+                }
+                case NODE48: {
+                    Node48 *y = static_cast<Node48 *>(x);
+                    Node16 *z = y->count - 1 > 12 ? nullptr : NewInner(pool16, NODE16, n >> 3);
+                    y->children[y->index[b] - 1] = 0;
+                    y->index[b] = 0;
+                    --y->count;
+                    if (!z)
+                        return;
+                    CopyHeader(z, y);
+                    for (int i = 0, k = 0; i < 256; ++i)
+                        if (y->index[i]) {
+                            z->keys[k] = i;
+                            z->children[k++] = y->children[y->index[i] - 1];
+                        }
+                    *slot = InnerRef(z);
+                    pool48.deallocate(y);
+                    return;
+                }
+                default: {
+                    Node256 *y = static_cast<Node256 *>(x);
+                    Node48 *z = y->count - 1 > 36 ? nullptr : NewInner(pool48, NODE48, n >> 5);
+                    y->children[b] = 0;
+                    --y->count;
+                    if (!z)
+                        return;
+                    CopyHeader(z, y);
+                    for (int i = 0, k = 0; i < 256; ++i)
+                        if (y->children[i]) {
+                            z->index[i] = k + 1;
+                            z->children[k++] = y->children[i];
+                        }
+                    *slot = InnerRef(z);
+                    pool256.deallocate(y);
+                    return;
+                }
+            }
+        }
+
+        // prefix bytes past the stored ones are skipped, the leaf reached
+        // is compared whole
+        Leaf *Find(const Key &key) const {
+            Bytes e = Encode(key);
+            Ref r = root;
+            size_t d = 0;
+            while (r && !IsLeaf(r)) {
+                Inner *x = AsInner(r);
+                for (size_t i = 0; i < Stored(x); ++i)
+                    if (x->prefix[i] != Byte(e, d + i))
+                        return const_cast<Leaf *>(&header);
+                d += x->prefix_len;
+                Ref *child = FindChild(x, Byte(e, d));
+                if (!child)
+                    return const_cast<Leaf *>(&header);
+                r = *child;
+                ++d;
+            }
+            if (r && EncodeLeaf(AsLeaf(r)) == e)
+                return AsLeaf(r);
+            return const_cast<Leaf *>(&header);
+        }
+
+        Leaf *Insert(const Key &key, const Value &value, bool &found) {
+            Bytes e = Encode(key);
+            Ref *slot = &root;
+            size_t d = 0;
+            found = false;
+            while (*slot) {
+                Ref r = *slot;
+                if (IsLeaf(r)) {
+                    Leaf *old = AsLeaf(r);
+                    Bytes f = EncodeLeaf(old);
+                    if (f == e) {
+                        found = true;
+                        return old;
+                    }
+                    // a Node4 above both leaves holding the bytes they share,
+                    // a key that stops there goes to its end slot
+                    size_t p = d;
+                    while (Byte(f, p) == Byte(e, p))
+                        ++p;
+                    Node4 *x = NewInner(pool4, NODE4, n >> 1);
+                    Leaf *l;
+                    try {
+                        l = NewLeaf(key, value);
+                    }
+                    catch (...) {
+                        pool4.deallocate(x);
+                        throw;
+                    }
+                    x->prefix_len = p - d;
+                    for (size_t i = 0; i < Stored(x); ++i)
+                        x->prefix[i] = Byte(e, d + i);
+                    AddChild(slot, x, Byte(f, p), r);
+                    AddChild(slot, x, Byte(e, p), LeafRef(l));
+                    *slot = InnerRef(x);
+                    return Added(l, e);
+                }
+                Inner *x = AsInner(r);
+                size_t i = Mismatch(r, e, d);
+                if (i < x->prefix_len) {
+                    // the key leaves the prefix at i: split it there
+                    Node4 *y = NewInner(pool4, NODE4, n >> 1);
+                    Leaf *l;
+                    try {
+                        l = NewLeaf(key, value);
+                    }
+                    catch (...) {
+                        pool4.deallocate(y);
+                        throw;
+                    }
+                    y->prefix_len = i;
+                    for (size_t j = 0; j < Stored(y); ++j)
+                        y->prefix[j] = x->prefix[j];
+                    // x keeps what follows byte i, read off a leaf when
+                    // that runs past the stored bytes
+                    int b = PrefixByte(r, d, i);
+                    if (x->prefix_len <= MAX_PREFIX)
+                        for (size_t j = i + 1; j < x->prefix_len; ++j)
+                            x->prefix[j - i - 1] = x->prefix[j];
+                    else {
+                        Bytes f = EncodeLeaf(Minimum(r));
+                        for (size_t j = 0; j < MAX_PREFIX && i + 1 + j < x->prefix_len; ++j)
+                            x->prefix[j] = Byte(f, d + i + 1 + j);
+                    }
+                    x->prefix_len -= i + 1;
+                    AddChild(slot, y, b, r);
+                    AddChild(slot, y, Byte(e, d + i), LeafRef(l));
+                    *slot = InnerRef(y);
+                    return Added(l, e);
+                }
+                d += x->prefix_len;
+                Ref *child = FindChild(x, Byte(e, d));
+                if (!child) {
+                    Leaf *l = NewLeaf(key, value);
+                    try {
+                        AddChild(slot, x, Byte(e, d), LeafRef(l));
+                    }
+                    catch (...) {
+                        l->Package()->~value_type();
+                        leaves.deallocate(l);
+                        throw;
+                    }
+                    return Added(l, e);
+                }
+                slot = child;
+                ++d;
+            }
+            Leaf *l = NewLeaf(key, value);
+            *slot = LeafRef(l);
+            return Added(l, e);
+        }
+
+        Leaf *Added(Leaf *l, Bytes e) {
+            ++n;
+            Link(l, e);
+            return l;
+        }
+
+        void Erase(Leaf *l) {
+            Bytes e = EncodeLeaf(l);
+            Ref *slot = &root, *xslot = nullptr;
+            Inner *x = nullptr;
+            size_t d = 0;
+            while (!IsLeaf(*slot)) {
+                x = AsInner(*slot);
+                xslot = slot;
+                d += x->prefix_len;
+                slot = FindChild(x, Byte(e, d));
+                ++d;
+            }
+            if (!x)
+                root = 0;
+            else
+                RemoveChild(xslot, x, Byte(e, d - 1));
+            l->prev->next = l->next;
+            l->next->prev = l->prev;
+            l->Package()->~value_type();
+            leaves.deallocate(l);
+            --n;
+        }
+
+        void Destruct() {
+            if (!std::is_trivially_destructible<value_type>::value)
+                for (Leaf *l = header.next; l != &header; l = l->next)
+                    l->Package()->~value_type();
+            leaves.release();
+            pool4.release();
+            pool16.release();
+            pool48.release();
+            pool256.release();
+            root = 0;
+            header.prev = header.next = &header;
+            n = 0;
+        }
+
+        // keys arrive in order, so every insert goes down the right edge
+        void Copy(const art_map &other) {
+            try {
+                for (const Leaf *l = other.header.next; l != &other.header; l = l->next) {
+                    bool found;
+                    Insert(l->Package()->first, l->Package()->second, found);
+                }
+            }
+            catch (...) {
+                Destruct();
+                throw;
+            }
+        }
+
+    public:
+        class const_iterator;
+        class iterator {
+        private:
+            Leaf *ptr;
+            art_map *source;
+
+            friend art_map;
+
+            iterator(Leaf *ptr, art_map *source):ptr(ptr), source(source) {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = Value;
+            using pointer = Value*;
+            using reference = Value&;
+            using iterator_category = std::output_iterator_tag;
+            using iterator_assignable = my_true_type;
+
+            iterator():ptr(nullptr), source(nullptr) {}
+
+            iterator operator++(int) {
+                iterator res = *this;
+                operator++();
+                return res;
+            }
+
+            iterator & operator++() {
+                if (!source || ptr == &source->header)
+                    throw invalid_iterator();
+                ptr = ptr->next;
+                return *this;
+            }
+
+            iterator operator--(int) {
+                iterator res = *this;
+                operator--();
+                return res;
+            }
+
+            iterator & operator--() {
+                if (!source || ptr->prev == &source->header)
+                    throw invalid_iterator();
+                ptr = ptr->prev;
+                return *this;
+            }
+
+            art_map::value_type & operator*() const {
+                return *ptr->Package();
+            }
+
+            art_map::value_type* operator->() const noexcept {
+                return ptr->Package();
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return ptr == rhs.ptr && source == rhs.source;
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return ptr == rhs.ptr && source == rhs.source;
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return !(*this == rhs);
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return !(*this == rhs);
+            }
+        };
+        class const_iterator {
+        private:
+            const Leaf *ptr;
+            const art_map *source;
+
+            friend art_map;
+
+            const_iterator(const Leaf *ptr, const art_map *source):ptr(ptr), source(source) {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = Value;
+            using pointer = Value*;
+            using reference = Value&;
+            using iterator_category = std::output_iterator_tag;
+            using iterator_assignable = my_false_type;
+
+            const_iterator():ptr(nullptr), source(nullptr) {}
+
+            const_iterator(const iterator &other):ptr(other.ptr), source(other.source) {}
+
+            const_iterator operator++(int) {
+                const_iterator res = *this;
+                operator++();
+                return res;
+            }
+
+            const_iterator & operator++() {
+                if (!source || ptr == &source->header)
+                    throw invalid_iterator();
+                ptr = ptr->next;
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator res = *this;
+                operator--();
+                return res;
+            }
+
+            const_iterator & operator--() {
+                if (!source || ptr->prev == &source->header)
+                    throw invalid_iterator();
+                ptr = ptr->prev;
+                return *this;
+            }
+
+            const art_map::value_type & operator*() const {
+                return *ptr->Package();
+            }
+
+            const art_map::value_type* operator->() const noexcept {
+                return ptr->Package();
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return ptr == rhs.ptr && source == rhs.source;
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return ptr == rhs.ptr && source == rhs.source;
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return !(*this == rhs);
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return !(*this == rhs);
+            }
+        };
+
+        art_map():root(0), n(0) {
+            header.prev = header.next = &header;
+        }
+
+        art_map(const art_map &other):root(0), n(0) {
+            header.prev = header.next = &header;
+            Copy(other);
+        }
+
+        art_map & operator=(const art_map &other) {
+            if (this == &other)
+                return *this;
+            Destruct();
+            Copy(other);
+            return *this;
+        }
+
+        ~art_map() {
+            Destruct();
+        }
+
+        Value & at(const Key &key) {
+            Leaf *l = Find(key);
+            if (l == &header)
+                throw index_out_of_bound();
+            return l->Package()->second;
+        }
+
+        const Value & at(const Key &key) const {
+            const Leaf *l = Find(key);
+            if (l == &header)
+                throw index_out_of_bound();
+            return l->Package()->second;
+        }
+
+        Value & operator[](const Key &key) {
+            bool found;
+            return Insert(key, Value(), found)->Package()->second;
+        }
+
+        const Value & operator[](const Key &key) const {
+            return at(key);
+        }
+
+        iterator begin() {
+            return iterator(header.next, this);
+        }
+
+        const_iterator cbegin() const {
+            return const_iterator(header.next, this);
+        }
+
+        iterator end() {
+            return iterator(&header, this);
+        }
+
+        const_iterator cend() const {
+            return const_iterator(&header, this);
+        }
+
+        bool empty() const {
+            return !n;
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        void clear() {
+            Destruct();
+        }
+
+        pair<iterator, bool> insert(const value_type &value) {
+            bool found;
+            Leaf *l = Insert(value.first, value.second, found);
+            return pair<iterator, bool>(iterator(l, this), !found);
+        }
+
+        void erase(iterator pos) {
+            if (pos.source != this || pos.ptr == &header)
+                throw invalid_iterator();
+            Erase(pos.ptr);
+        }
+
+        size_t count(const Key &key) const {
+            return Find(key) != &header;
+        }
+
+        iterator find(const Key &key) {
+            return iterator(Find(key), this);
+        }
+
+        const_iterator find(const Key &key) const {
+            return const_iterator(Find(key), this);
+        }
+    };
+}
+
+#endif
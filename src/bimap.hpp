@@ -0,0 +1,373 @@
+#ifndef SJTU_BIMAP_HPP
+#define SJTU_BIMAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "node_pool.hpp"
+#include "intrusive_tree.hpp"
+
+namespace sjtu {
+    template<class Value, class Projection>
+    struct bimap_projected {
+        typedef typename std::decay<decltype(std::declval<const Projection &>()(
+                std::declval<const Value &>()))>::type type;
+    };
+
+    // a map with a second ordered index on Projection(value), for the
+    // map<Id, Score> plus map<Score, Id> pattern: every element is one
+    // allocation carrying the hooks of two intrusive_trees, unique on key
+    // and ordered with ties on the projection, and an update relinks it in
+    // the second tree only. Values are read-only through iterators, change
+    // them with insert_or_assign. Projection returns a reference into the
+    // value (a field, or the value itself)
+    template<
+            class Key,
+            class Value,
+            class Projection = rb_identity<Value>,
+            class Compare = std::less<Key>,
+            class ProjectionCompare = std::less<typename bimap_projected<Value, Projection>::type>,
+            class Allocator = std::allocator<pair<const Key, Value>>
+    > class bimap {
+    public:
+        typedef pair<const Key, Value> value_type;
+        typedef typename bimap_projected<Value, Projection>::type projected_type;
+
+    private:
+        struct ByKey;
+        struct ByValue;
+
+        // the package is built and destroyed apart from the hooks, so the
+        // trees stay walkable while packages are torn down
+        struct Element : rb_hook<ByKey>, rb_hook<ByValue> {
+            alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+            value_type *Package() {
+                return reinterpret_cast<value_type *>(storage);
+            }
+
+            const value_type *Package() const {
+                return reinterpret_cast<const value_type *>(storage);
+            }
+        };
+
+        struct KeyOf {
+            const Key &operator()(const Element &x) const {
+                return x.Package()->first;
+            }
+        };
+
+        struct ProjectionOf {
+            Projection projection;
+
+            const projected_type &operator()(const Element &x) const {
+                return projection(x.Package()->second);
+            }
+        };
+
+        typedef intrusive_tree<Element, Key, KeyOf, Compare, ByKey> KeyTree;
+        typedef intrusive_tree<Element, projected_type, ProjectionOf, ProjectionCompare, ByValue> ValueTree;
+
+        node_pool<Element, Allocator> pool;
+        KeyTree by_key;
+        ValueTree by_value;
+
+        Element *NewElement(const Key &key, const Value &value) {
+            Element *x = new (pool.allocate(by_key.size())) Element;
+            try {
+                new (x->storage) value_type(key, value);
+            }
+            catch (...) {
+                pool.deallocate(x);
+                throw;
+            }
+            return x;
+        }
+
+        void FreeElement(Element *x) {
+            x->Package()->~value_type();
+            pool.deallocate(x);
+        }
+
+        void DeleteElement(Element *x) {
+            by_key.erase(*x);
+            by_value.erase(*x);
+            FreeElement(x);
+        }
+
+        // links x (already in by_key) into by_value; if the projection
+        // compare throws, x leaves the map so both trees keep the same
+        // elements
+        void LinkValue(Element *x) {
+            try {
+                by_value.insert_equal(*x);
+            }
+            catch (...) {
+                by_key.erase(*x);
+                FreeElement(x);
+                throw;
+            }
+        }
+
+        // the element under key, a new one built from value when there is
+        // none (true); a single descent of by_key either way, the new
+        // element is dropped again when the key turns out to be there
+        pair<typename KeyTree::iterator, bool> Insert(const Key &key, const Value &value) {
+            Element *x = NewElement(key, value);
+            typename KeyTree::iterator it;
+            bool added;
+            try {
+                pair<typename KeyTree::iterator, bool> res = by_key.insert(*x);
+                it = res.first;
+                added = res.second;
+            }
+            catch (...) {
+                FreeElement(x);
+                throw;
+            }
+            if (!added)
+                FreeElement(x);
+            else
+                LinkValue(x);
+            return pair<typename KeyTree::iterator, bool>(it, added);
+        }
+
+        void Destruct() {
+            if (!std::is_trivially_destructible<value_type>::value)
+                for (typename KeyTree::iterator it = by_key.begin(); it != by_key.end(); ++it)
+                    it->Package()->~value_type();
+            by_key.clear();
+            by_value.clear();
+            pool.release();
+        }
+
+        void Copy(const bimap &other) {
+            try {
+                for (typename KeyTree::const_iterator it = other.by_key.cbegin(); it != other.by_key.cend(); ++it)
+                    Insert(it->Package()->first, it->Package()->second);
+            }
+            catch (...) {
+                Destruct();
+                throw;
+            }
+        }
+
+        // an iterator of one of the trees that shows the package
+        template<class Base>
+        class Cursor {
+        private:
+            Base it;
+            const bimap *source;
+
+            friend bimap;
+
+            Cursor(const Base &it, const bimap *source):it(it), source(source) {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = bimap::value_type;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+            using iterator_category = std::output_iterator_tag;
+            using iterator_assignable = my_false_type;
+
+            Cursor():source(nullptr) {}
+
+            Cursor operator++(int) {
+                Cursor res = *this;
+                operator++();
+                return res;
+            }
+
+            Cursor & operator++() {
+                ++it;
+                return *this;
+            }
+
+            Cursor operator--(int) {
+                Cursor res = *this;
+                operator--();
+                return res;
+            }
+
+            Cursor & operator--() {
+                --it;
+                return *this;
+            }
+
+            const value_type & operator*() const {
+                return *it->Package();
+            }
+
+            const value_type* operator->() const noexcept {
+                return it->Package();
+            }
+
+            bool operator==(const Cursor &rhs) const {
+                return it == rhs.it;
+            }
+
+            bool operator!=(const Cursor &rhs) const {
+                return it != rhs.it;
+            }
+        };
+
+    public:
+        // in key order
+        typedef Cursor<typename KeyTree::const_iterator> const_iterator;
+        typedef const_iterator iterator;
+        // in projection order, ties in the order they got their value
+        typedef Cursor<typename ValueTree::const_iterator> value_iterator;
+
+        bimap() {}
+
+        bimap(const bimap &other):pool(std::allocator_traits<typename node_pool<Element, Allocator>::allocator_type>::
+                select_on_container_copy_construction(other.pool.get_allocator())) {
+            Copy(other);
+        }
+
+        bimap & operator=(const bimap &other) {
+            if (this == &other)
+                return *this;
+            Destruct();
+            Copy(other);
+            return *this;
+        }
+
+        ~bimap() {
+            Destruct();
+        }
+
+        const Value & at(const Key &key) const {
+            typename KeyTree::const_iterator it = by_key.find(key);
+            if (it == by_key.cend())
+                throw index_out_of_bound();
+            return it->Package()->second;
+        }
+
+        const_iterator begin() const {
+            return cbegin();
+        }
+
+        const_iterator cbegin() const {
+            return const_iterator(by_key.cbegin(), this);
+        }
+
+        const_iterator end() const {
+            return cend();
+        }
+
+        const_iterator cend() const {
+            return const_iterator(by_key.cend(), this);
+        }
+
+        value_iterator value_begin() const {
+            return value_iterator(by_value.cbegin(), this);
+        }
+
+        value_iterator value_end() const {
+            return value_iterator(by_value.cend(), this);
+        }
+
+        bool empty() const {
+            return by_key.empty();
+        }
+
+        size_t size() const {
+            return by_key.size();
+        }
+
+        void clear() {
+            Destruct();
+        }
+
+        pair<iterator, bool> insert(const value_type &value) {
+            pair<typename KeyTree::iterator, bool> res = Insert(value.first, value.second);
+            return pair<iterator, bool>(iterator(res.first, this), res.second);
+        }
+
+        // sets the value under key, adding the key if it is new; the second
+        // index is updated in the same call. true if the key was added. If
+        // the projection compare throws, the key is erased
+        pair<iterator, bool> insert_or_assign(const Key &key, const Value &value) {
+            pair<typename KeyTree::iterator, bool> res = Insert(key, value);
+            if (res.second)
+                return pair<iterator, bool>(iterator(res.first, this), true);
+            Element *x = &*res.first;
+            by_value.erase(*x);
+            try {
+                x->Package()->second = value;
+            }
+            catch (...) {
+                LinkValue(x);
+                throw;
+            }
+            LinkValue(x);
+            return pair<iterator, bool>(iterator(res.first, this), false);
+        }
+
+        void erase(const_iterator pos) {
+            if (pos.source != this || pos == cend())
+                throw invalid_iterator();
+            DeleteElement(const_cast<Element *>(&*pos.it));
+        }
+
+        void erase(value_iterator pos) {
+            if (pos.source != this || pos == value_end())
+                throw invalid_iterator();
+            DeleteElement(const_cast<Element *>(&*pos.it));
+        }
+
+        size_t erase(const Key &key) {
+            typename KeyTree::iterator it = by_key.find(key);
+            if (it == by_key.end())
+                return 0;
+            DeleteElement(&*it);
+            return 1;
+        }
+
+        size_t count(const Key &key) const {
+            return by_key.count(key);
+        }
+
+        const_iterator find(const Key &key) const {
+            return const_iterator(by_key.find(key), this);
+        }
+
+        const_iterator lower_bound(const Key &key) const {
+            return const_iterator(by_key.lower_bound(key), this);
+        }
+
+        const_iterator upper_bound(const Key &key) const {
+            return const_iterator(by_key.upper_bound(key), this);
+        }
+
+        value_iterator value_lower_bound(const projected_type &p) const {
+            return value_iterator(by_value.lower_bound(p), this);
+        }
+
+        value_iterator value_upper_bound(const projected_type &p) const {
+            return value_iterator(by_value.upper_bound(p), this);
+        }
+
+        // the elements whose value projects to p, [first, second)
+        pair<value_iterator, value_iterator> value_equal_range(const projected_type &p) const {
+            return pair<value_iterator, value_iterator>(value_lower_bound(p), value_upper_bound(p));
+        }
+
+        size_t value_count(const projected_type &p) const {
+            size_t res = 0;
+            for (value_iterator it = value_lower_bound(p), last = value_upper_bound(p); it != last; ++it)
+                ++res;
+            return res;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef SJTU_BLOOM_FILTER_HPP
+#define SJTU_BLOOM_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sjtu {
+    // split block Bloom filter: a key picks one 256-bit block and sets one
+    // bit in each of its eight 32-bit words, so a query reads a single
+    // block and never follows a second cache miss. Hash is kept behind a
+    // virtual call so the owner's type does not depend on it. No false
+    // negatives; false positives run about 1.3% at 10 bits per key and
+    // 0.13% at 16
+    template<class Key>
+    class bloom_filter {
+    private:
+        static const int WORDS = 8;
+
+        struct alignas(32) Block {
+            uint32_t word[WORDS];
+        };
+
+        struct Hasher {
+            virtual ~Hasher() {}
+
+            virtual size_t operator()(const Key &key) const = 0;
+
+            virtual Hasher *Clone() const = 0;
+        };
+
+        template<class Hash>
+        struct HasherOf : Hasher {
+            Hash hash;
+
+            explicit HasherOf(const Hash &hash):hash(hash) {}
+
+            size_t operator()(const Key &key) const {
+                return hash(key);
+            }
+
+            Hasher *Clone() const {
+                return new HasherOf(hash);
+            }
+        };
+
+        std::vector<Block> blocks;
+        Hasher *hasher;
+        size_t bits_per_key;
+        size_t n, limit;
+
+        static uint64_t Mix(uint64_t x) {
+            x += 0x9e3779b97f4a7c15ull;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+        }
+
+        // the block from the high half of the hash, the bits from the low
+        size_t Pick(uint64_t h) const {
+#if defined(__SIZEOF_INT128__)
+            return (size_t)(((unsigned __int128)h * blocks.size()) >> 64);
+#else
+            return (h >> 32) % blocks.size();
+#endif
+        }
+
+        static uint32_t Bit(uint32_t h, int i) {
+            static const uint32_t SALT[WORDS] = {0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+                                                 0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u};
+            return 1u << ((h * SALT[i]) >> 27);
+        }
+
+        uint64_t HashOf(const Key &key) const {
+            return Mix((*hasher)(key));
+        }
+
+    public:
+        // sized for capacity keys, see reset()
+        template<class Hash>
+        bloom_filter(const Hash &hash, size_t bits_per_key, size_t capacity):
+                hasher(new HasherOf<Hash>(hash)), bits_per_key(bits_per_key ? bits_per_key : 1) {
+            try {
+                reset(capacity);
+            }
+            catch (...) {
+                delete hasher;
+                throw;
+            }
+        }
+
+        bloom_filter(const bloom_filter &other):blocks(other.blocks), hasher(other.hasher->Clone()),
+                bits_per_key(other.bits_per_key), n(other.n), limit(other.limit) {}
+
+        // an empty filter with other's hash and bits per key, sized for
+        // capacity keys
+        bloom_filter(const bloom_filter &other, size_t capacity):
+                hasher(other.hasher->Clone()), bits_per_key(other.bits_per_key) {
+            try {
+                reset(capacity);
+            }
+            catch (...) {
+                delete hasher;
+                throw;
+            }
+        }
+
+        bloom_filter & operator=(const bloom_filter &other) {
+            if (this == &other)
+                return *this;
+            Hasher *h = other.hasher->Clone();
+            try {
+                blocks = other.blocks;
+            }
+            catch (...) {
+                delete h;
+                throw;
+            }
+            delete hasher;
+            hasher = h;
+            bits_per_key = other.bits_per_key;
+            n = other.n;
+            limit = other.limit;
+            return *this;
+        }
+
+        ~bloom_filter() {
+            delete hasher;
+        }
+
+        // empties the filter and sizes it for capacity keys
+        void reset(size_t capacity) {
+            size_t m = (capacity * bits_per_key + 255) / 256;
+            blocks.assign(m ? m : 1, Block());
+            n = 0;
+            limit = capacity;
+        }
+
+        // forgets every key, the size stays
+        void clear() {
+            for (size_t i = 0; i < blocks.size(); ++i)
+                blocks[i] = Block();
+            n = 0;
+        }
+
+        void insert(const Key &key) {
+            uint64_t h = HashOf(key);
+            Block &b = blocks[Pick(h)];
+            for (int i = 0; i < WORDS; ++i)
+                b.word[i] |= Bit((uint32_t)h, i);
+            ++n;
+        }
+
+        // false means key was never inserted
+        bool might_contain(const Key &key) const {
+            uint64_t h = HashOf(key);
+            const Block &b = blocks[Pick(h)];
+            uint32_t miss = 0;
+            for (int i = 0; i < WORDS; ++i)
+                miss |= Bit((uint32_t)h, i) & ~b.word[i];
+            return !miss;
+        }
+
+        // insertions since the last reset; past capacity() the false
+        // positive rate climbs
+        size_t size() const {
+            return n;
+        }
+
+        size_t capacity() const {
+            return limit;
+        }
+
+        // estimated from how full the words are: a query of an absent key
+        // passes when each of its eight bits happens to be set in its block
+        double false_positive_rate() const {
+            double res = 0;
+            for (size_t i = 0; i < blocks.size(); ++i) {
+                double p = 1;
+                for (int j = 0; j < WORDS; ++j)
+                    p *= __builtin_popcount(blocks[i].word[j]) / 32.0;
+                res += p;
+            }
+            return res / blocks.size();
+        }
+
+        size_t memory_bytes() const {
+            return blocks.size() * sizeof(Block);
+        }
+    };
+}
+
+#endif
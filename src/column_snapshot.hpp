@@ -0,0 +1,233 @@
+#ifndef SJTU_COLUMN_SNAPSHOT_HPP
+#define SJTU_COLUMN_SNAPSHOT_HPP
+
+#include <functional>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "exceptions.hpp"
+
+namespace sjtu {
+    // frozen structure-of-arrays copy of a map: keys and values live in two
+    // contiguous arrays in ascending key order, ranges are [lo, hi)
+    template<
+            class Key,
+            class Value,
+            class Compare = std::less<Key>
+    > class column_snapshot {
+    private:
+        Key *key_column;
+        Value *value_column;
+        size_t n, capacity;
+        Compare comp;
+
+        // on failure the snapshot is left empty with nothing allocated
+        void Allocate(size_t cap) {
+            key_column = nullptr;
+            value_column = nullptr;
+            n = capacity = 0;
+            if (!cap)
+                return;
+            key_column = static_cast<Key *>(::operator new(cap * sizeof(Key)));
+            try {
+                value_column = static_cast<Value *>(::operator new(cap * sizeof(Value)));
+            }
+            catch (...) {
+                ::operator delete(key_column);
+                key_column = nullptr;
+                throw;
+            }
+            capacity = cap;
+        }
+
+        // builds a copy of other's elements, releasing it all if one throws
+        void CopyFrom(const column_snapshot &other) {
+            Allocate(other.n);
+            try {
+                for (size_t i = 0; i < other.n; ++i)
+                    push_back(other.key_column[i], other.value_column[i]);
+            }
+            catch (...) {
+                Release();
+                throw;
+            }
+        }
+
+        void Release() {
+            for (size_t i = 0; i < n; ++i) {
+                key_column[i].~Key();
+                value_column[i].~Value();
+            }
+            ::operator delete(key_column);
+            ::operator delete(value_column);
+            key_column = nullptr;
+            value_column = nullptr;
+            n = capacity = 0;
+        }
+
+        // branch-free lower bound, the loop body compiles to a conditional move
+        size_t LowerBound(const Key &key) const {
+            if (!n)
+                return 0;
+            const Key *base = key_column;
+            size_t len = n;
+            while (len > 1) {
+                size_t half = len / 2;
+                base = comp(base[half], key) ? base + half : base;
+                len -= half;
+            }
+            return (base - key_column) + comp(*base, key);
+        }
+
+    public:
+        column_snapshot() {
+            Allocate(0);
+        }
+
+        explicit column_snapshot(size_t cap) {
+            Allocate(cap);
+        }
+
+        column_snapshot(const column_snapshot &other):comp(other.comp) {
+            CopyFrom(other);
+        }
+
+        column_snapshot(column_snapshot &&other):key_column(other.key_column), value_column(other.value_column),
+                n(other.n), capacity(other.capacity), comp(other.comp) {
+            other.key_column = nullptr;
+            other.value_column = nullptr;
+            other.n = other.capacity = 0;
+        }
+
+        column_snapshot & operator=(const column_snapshot &other) {
+            if (this == &other)
+                return *this;
+            column_snapshot tmp(other);
+            Release();
+            std::swap(key_column, tmp.key_column);
+            std::swap(value_column, tmp.value_column);
+            std::swap(n, tmp.n);
+            std::swap(capacity, tmp.capacity);
+            comp = other.comp;
+            return *this;
+        }
+
+        ~column_snapshot() {
+            Release();
+        }
+
+        // keys must arrive in ascending order, used by map::snapshot
+        void push_back(const Key &key, const Value &value) {
+            if (n == capacity)
+                throw runtime_error();
+            new (key_column + n) Key(key);
+            try {
+                new (value_column + n) Value(value);
+            }
+            catch (...) {
+                key_column[n].~Key();
+                throw;
+            }
+            ++n;
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        bool empty() const {
+            return !n;
+        }
+
+        const Key *keys() const {
+            return key_column;
+        }
+
+        const Value *values() const {
+            return value_column;
+        }
+
+        size_t lower_bound(const Key &key) const {
+            return LowerBound(key);
+        }
+
+        size_t find(const Key &key) const {
+            size_t i = LowerBound(key);
+            if (i == n || comp(key, key_column[i]))
+                return n;
+            return i;
+        }
+
+        size_t count(const Key &lo, const Key &hi) const {
+            size_t l = LowerBound(lo), r = LowerBound(hi);
+            return l < r ? r - l : 0;
+        }
+
+        // the kernels below are written as straight loops over the value
+        // column with no early exits so the compiler can vectorize them
+        template<class T = Value>
+        T sum(const Key &lo, const Key &hi) const {
+            size_t l = LowerBound(lo), r = LowerBound(hi);
+            const Value *v = value_column;
+            T s0 = T(), s1 = T(), s2 = T(), s3 = T();
+            size_t i = l;
+            for (; i + 4 <= r; i += 4) {
+                s0 += v[i];
+                s1 += v[i + 1];
+                s2 += v[i + 2];
+                s3 += v[i + 3];
+            }
+            for (; i < r; ++i)
+                s0 += v[i];
+            return (s0 + s1) + (s2 + s3);
+        }
+
+        Value min(const Key &lo, const Key &hi) const {
+            size_t l = LowerBound(lo), r = LowerBound(hi);
+            if (l >= r)
+                throw container_is_empty();
+            const Value *v = value_column;
+            Value res = v[l];
+            for (size_t i = l + 1; i < r; ++i)
+                res = v[i] < res ? v[i] : res;
+            return res;
+        }
+
+        Value max(const Key &lo, const Key &hi) const {
+            size_t l = LowerBound(lo), r = LowerBound(hi);
+            if (l >= r)
+                throw container_is_empty();
+            const Value *v = value_column;
+            Value res = v[l];
+            for (size_t i = l + 1; i < r; ++i)
+                res = res < v[i] ? v[i] : res;
+            return res;
+        }
+
+        template<class Pred>
+        size_t count_if(const Key &lo, const Key &hi, Pred pred) const {
+            size_t l = LowerBound(lo), r = LowerBound(hi);
+            const Value *v = value_column;
+            size_t res = 0;
+            for (size_t i = l; i < r; ++i)
+                res += pred(v[i]) ? 1 : 0;
+            return res;
+        }
+
+        // writes positions of matching values into out (a selection vector),
+        // out must hold count(lo, hi) entries, returns the number written
+        template<class Pred>
+        size_t filter(const Key &lo, const Key &hi, Pred pred, size_t *out) const {
+            size_t l = LowerBound(lo), r = LowerBound(hi);
+            const Value *v = value_column;
+            size_t k = 0;
+            for (size_t i = l; i < r; ++i) {
+                out[k] = i;
+                k += pred(v[i]) ? 1 : 0;
+            }
+            return k;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef SJTU_COMPACT_MAP_HPP
+#define SJTU_COMPACT_MAP_HPP
+
+#include <functional>
+#include "utility.hpp"
+#include "index_tree.hpp"
+
+namespace sjtu {
+    // red-black map for very large sizes: nodes sit in a slab and link to
+    // each other by 32-bit indices, the color is the low bit of the parent
+    // link and index 0 is the shared black leaf, so a map<int, int> node
+    // takes 20 bytes
+    template<
+            class Key,
+            class Value,
+            class Compare = std::less<Key>
+    > class compact_map : public index_tree<Key, Value, Compare, index_slab<pair<const Key, Value>>> {
+        typedef index_tree<Key, Value, Compare, index_slab<pair<const Key, Value>>> Base;
+
+    public:
+        using Base::Base;
+    };
+}
+
+#endif
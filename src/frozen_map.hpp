@@ -0,0 +1,163 @@
+#ifndef SJTU_FROZEN_MAP_HPP
+#define SJTU_FROZEN_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+    // immutable map of exactly N entries that can be built by the compiler:
+    // a constexpr frozen_map is sorted and checked for duplicate keys during
+    // compilation (a duplicate or a missing at() key there is a compile
+    // error) and lands in read-only data; keys sit in Eytzinger order
+    // (node k has children 2k and 2k + 1) so a lookup is a branch-free
+    // descent plus one final comparison. Key and Value must be literal and
+    // default constructible
+    template<
+            class Key,
+            class Value,
+            size_t N,
+            class Compare = std::less<Key>
+    > class frozen_map {
+    private:
+        // slot 0 is unused, a descent that falls off the array lands there
+        Key keys[N + 1] = {};
+        Value values[N + 1] = {};
+        Compare comp = Compare();
+
+        template<class T>
+        static constexpr void Swap(T &a, T &b) {
+            T t = a;
+            a = b;
+            b = t;
+        }
+
+        constexpr void SiftDown(Key *k, Value *v, size_t i, size_t size) {
+            while (2 * i + 1 < size) {
+                size_t j = 2 * i + 1;
+                if (j + 1 < size && comp(k[j], k[j + 1]))
+                    ++j;
+                if (!comp(k[i], k[j]))
+                    return;
+                Swap(k[i], k[j]);
+                Swap(v[i], v[j]);
+                i = j;
+            }
+        }
+
+        // heapsort: in place and O(N log N) steps, which keeps large tables
+        // within the compiler's constexpr budget
+        constexpr void Sort(Key *k, Value *v) {
+            for (size_t i = N / 2; i--; )
+                SiftDown(k, v, i, N);
+            for (size_t i = N; i > 1; --i) {
+                Swap(k[0], k[i - 1]);
+                Swap(v[0], v[i - 1]);
+                SiftDown(k, v, 0, i - 1);
+            }
+            for (size_t i = 1; i < N; ++i)
+                if (!comp(k[i - 1], k[i]))
+                    throw runtime_error();
+        }
+
+        // in-order walk of the implicit tree hands out the sorted entries
+        constexpr void Lay(const Key *k, const Value *v, size_t x, size_t &i) {
+            if (x > N)
+                return;
+            Lay(k, v, 2 * x, i);
+            keys[x] = k[i];
+            values[x] = v[i];
+            ++i;
+            Lay(k, v, 2 * x + 1, i);
+        }
+
+        constexpr void Build(Key *k, Value *v) {
+            Sort(k, v);
+            size_t i = 0;
+            Lay(k, v, 1, i);
+        }
+
+        static constexpr size_t TrailingOnes(size_t x) {
+#if defined(__GNUC__)
+            return __builtin_ctzll(~(unsigned long long)x);
+#else
+            size_t res = 0;
+            for (; x & 1; x >>= 1)
+                ++res;
+            return res;
+#endif
+        }
+
+        // slot of the first key not less than key, 0 if there is none
+        constexpr size_t LowerBound(const Key &key) const {
+            size_t x = 1;
+            while (x <= N)
+                x = 2 * x + comp(keys[x], key);
+            return x >> (TrailingOnes(x) + 1);
+        }
+
+        constexpr size_t Find(const Key &key) const {
+            size_t x = LowerBound(key);
+            return x && !comp(key, keys[x]) ? x : 0;
+        }
+
+    public:
+        constexpr frozen_map(const pair<Key, Value> (&items)[N]) {
+            Key k[N + 1] = {};
+            Value v[N + 1] = {};
+            for (size_t i = 0; i < N; ++i) {
+                k[i] = items[i].first;
+                v[i] = items[i].second;
+            }
+            Build(k, v);
+        }
+
+        constexpr frozen_map(const Key (&key_list)[N], const Value (&value_list)[N]) {
+            Key k[N + 1] = {};
+            Value v[N + 1] = {};
+            for (size_t i = 0; i < N; ++i) {
+                k[i] = key_list[i];
+                v[i] = value_list[i];
+            }
+            Build(k, v);
+        }
+
+        static constexpr size_t size() {
+            return N;
+        }
+
+        static constexpr bool empty() {
+            return !N;
+        }
+
+        constexpr size_t count(const Key &key) const {
+            return Find(key) != 0;
+        }
+
+        // nullptr when key is absent
+        constexpr const Value *find(const Key &key) const {
+            size_t x = Find(key);
+            return x ? values + x : nullptr;
+        }
+
+        constexpr const Value & at(const Key &key) const {
+            size_t x = Find(key);
+            if (!x)
+                throw index_out_of_bound();
+            return values[x];
+        }
+
+        constexpr const Value & operator[](const Key &key) const {
+            return at(key);
+        }
+    };
+
+    // deduces N from a braced list: make_frozen_map<int, int>({{1, 2}, {3, 4}})
+    template<class Key, class Value, class Compare = std::less<Key>, size_t N>
+    constexpr frozen_map<Key, Value, N, Compare> make_frozen_map(const pair<Key, Value> (&items)[N]) {
+        return frozen_map<Key, Value, N, Compare>(items);
+    }
+}
+
+#endif
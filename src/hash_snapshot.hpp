@@ -0,0 +1,219 @@
+#ifndef SJTU_HASH_SNAPSHOT_HPP
+#define SJTU_HASH_SNAPSHOT_HPP
+
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "exceptions.hpp"
+#include "column_snapshot.hpp"
+
+namespace sjtu {
+    // frozen copy of a map for point lookups: a minimal perfect hash sends
+    // each key to its own slot in [0, n) and keys and values sit in flat
+    // arrays in slot order, so a lookup hashes, reads one pilot and checks
+    // one slot; order keeps the slots in ascending key order for scans.
+    // The hash is hash-and-displace in the PTHash style: keys fall into
+    // buckets of about 5, and each bucket gets a 32-bit pilot that moves
+    // all its keys into free slots at once, biggest buckets first
+    template<
+            class Key,
+            class Value,
+            class Hash = std::hash<Key>,
+            class Compare = std::less<Key>
+    > class hash_snapshot {
+    private:
+        static const size_t BUCKET_SIZE = 5;
+        static const uint32_t MAX_PILOT = 1u << 24;
+        // a good hash almost never needs a second seed
+        static const int MAX_SEEDS = 16;
+
+        std::vector<Key> keys;
+        std::vector<Value> values;
+        std::vector<uint32_t> pilots;
+        std::vector<uint32_t> order;
+        uint64_t seed;
+        Hash hash;
+        Compare comp;
+
+        static uint64_t Mix(uint64_t x) {
+            x += 0x9e3779b97f4a7c15ull;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+        }
+
+        // maps a uniform x into [0, m) with a multiply instead of a divide
+        static size_t Range(uint64_t x, size_t m) {
+#if defined(__SIZEOF_INT128__)
+            return (size_t)(((unsigned __int128)x * m) >> 64);
+#else
+            return x % m;
+#endif
+        }
+
+        uint64_t HashOf(const Key &key) const {
+            return Mix(hash(key) ^ seed);
+        }
+
+        // the bucket comes from the low half of the hash and the slot from
+        // the hash times an odd factor derived from the pilot; xoring the
+        // pilot in would only ever flip the same few top bits
+        size_t Bucket(uint64_t h) const {
+            return (size_t)(((h & 0xffffffffull) * pilots.size()) >> 32);
+        }
+
+        static size_t Slot(uint64_t h, uint32_t pilot, size_t m) {
+            return Range(h * (Mix(pilot) | 1), m);
+        }
+
+        bool Equal(const Key &a, const Key &b) const {
+            return !comp(a, b) && !comp(b, a);
+        }
+
+        size_t Find(const Key &key) const {
+            size_t n = keys.size();
+            if (!n)
+                return 0;
+            uint64_t h = HashOf(key);
+            size_t x = Slot(h, pilots[Bucket(h)], n);
+            return Equal(keys[x], key) ? x : n;
+        }
+
+        // fills slot_of with each sorted key's slot, false if some bucket
+        // found no pilot and a new seed is needed. Two keys with equal
+        // hash(key) share every slot under every seed, so that throws
+        bool Build(const Key *sorted, size_t n, std::vector<uint32_t> &slot_of) {
+            size_t r = pilots.size();
+            std::vector<uint64_t> h(n);
+            std::vector<uint32_t> start(r + 1, 0), member(n);
+            for (size_t i = 0; i < n; ++i) {
+                h[i] = HashOf(sorted[i]);
+                ++start[Bucket(h[i]) + 1];
+            }
+            size_t largest = 0;
+            for (size_t b = 0; b < r; ++b) {
+                largest = start[b + 1] > largest ? start[b + 1] : largest;
+                start[b + 1] += start[b];
+            }
+            std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+            for (size_t i = 0; i < n; ++i)
+                member[fill[Bucket(h[i])]++] = i;
+            // buckets by size, largest first (counting sort)
+            std::vector<uint32_t> by_size(largest + 2, 0), queue(r);
+            for (size_t b = 0; b < r; ++b)
+                ++by_size[largest - (start[b + 1] - start[b]) + 1];
+            for (size_t s = 0; s <= largest; ++s)
+                by_size[s + 1] += by_size[s];
+            for (size_t b = 0; b < r; ++b)
+                queue[by_size[largest - (start[b + 1] - start[b])]++] = b;
+            std::vector<char> taken(n, 0);
+            std::vector<size_t> slots(largest);
+            for (size_t q = 0; q < r; ++q) {
+                size_t b = queue[q], size = start[b + 1] - start[b];
+                if (!size)
+                    break;
+                for (size_t i = start[b]; i < start[b + 1]; ++i)
+                    for (size_t j = start[b]; j < i; ++j)
+                        if (h[member[i]] == h[member[j]])
+                            throw runtime_error();
+                uint32_t pilot = 0;
+                for (; pilot < MAX_PILOT; ++pilot) {
+                    size_t k = 0;
+                    for (; k < size; ++k) {
+                        size_t x = Slot(h[member[start[b] + k]], pilot, n);
+                        if (taken[x])
+                            break;
+                        taken[x] = 1;
+                        slots[k] = x;
+                    }
+                    if (k == size)
+                        break;
+                    while (k--)
+                        taken[slots[k]] = 0;
+                }
+                if (pilot == MAX_PILOT)
+                    return false;
+                pilots[b] = pilot;
+                for (size_t k = 0; k < size; ++k)
+                    slot_of[member[start[b] + k]] = slots[k];
+            }
+            return true;
+        }
+
+    public:
+        explicit hash_snapshot(const Hash &hash = Hash()):seed(0), hash(hash) {}
+
+        // keys of sorted must be distinct, as in map::snapshot, and so must
+        // their hashes; throws runtime_error when no perfect hash is found
+        explicit hash_snapshot(const column_snapshot<Key, Value, Compare> &sorted, const Hash &hash = Hash()):
+                seed(0), hash(hash) {
+            size_t n = sorted.size();
+            if (n > 0xffffffffull)
+                throw runtime_error();
+            if (!n)
+                return;
+            pilots.resize(n / BUCKET_SIZE + 1);
+            std::vector<uint32_t> slot_of(n);
+            for (int tries = 1; !Build(sorted.keys(), n, slot_of); ++tries) {
+                if (tries == MAX_SEEDS)
+                    throw runtime_error();
+                seed = Mix(seed + 1);
+            }
+            std::vector<uint32_t> at(n);
+            for (size_t i = 0; i < n; ++i)
+                at[slot_of[i]] = i;
+            keys.reserve(n);
+            values.reserve(n);
+            for (size_t x = 0; x < n; ++x) {
+                keys.push_back(sorted.keys()[at[x]]);
+                values.push_back(sorted.values()[at[x]]);
+            }
+            order.swap(slot_of);
+        }
+
+        size_t size() const {
+            return keys.size();
+        }
+
+        bool empty() const {
+            return keys.empty();
+        }
+
+        size_t count(const Key &key) const {
+            return Find(key) != keys.size();
+        }
+
+        // nullptr when key is absent
+        const Value *find(const Key &key) const {
+            size_t x = Find(key);
+            return x != keys.size() ? &values[x] : nullptr;
+        }
+
+        const Value & at(const Key &key) const {
+            size_t x = Find(key);
+            if (x == keys.size())
+                throw index_out_of_bound();
+            return values[x];
+        }
+
+        const Value & operator[](const Key &key) const {
+            return at(key);
+        }
+
+        // visits f(key, value) in ascending key order
+        template<class F>
+        void for_each(F f) const {
+            for (size_t i = 0; i < order.size(); ++i)
+                f(keys[order[i]], values[order[i]]);
+        }
+
+        // size of the hash function itself (the pilots), the flat arrays
+        // and the order side array not counted
+        double bits_per_key() const {
+            return keys.empty() ? 0 : 32.0 * pilots.size() / keys.size();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef SJTU_HUGE_PAGE_ALLOCATOR_HPP
+#define SJTU_HUGE_PAGE_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <sys/mman.h>
+
+namespace sjtu {
+    // bump arena over anonymous mappings aligned to 2M and advised for
+    // transparent huge pages, so a node pool built on it covers a big map
+    // with a few TLB entries; freed chunks are reused by requests of the
+    // same size (node pools ask for the same block sizes again) and the
+    // mappings are trimmed once every allocation is gone
+    class huge_page_arena {
+    public:
+        static const size_t HUGE_PAGE = size_t(2) << 20;
+        static const size_t DEFAULT_RESERVE = size_t(64) << 20;
+
+    private:
+        struct Region {
+            char *base;
+            size_t size;
+        };
+
+        struct Chunk {
+            void *p;
+            size_t bytes;
+        };
+
+        std::mutex lock;
+        std::vector<Region> regions;
+        std::vector<Chunk> spare;
+        char *cursor, *limit;
+        size_t live, next_size;
+
+        static size_t RoundUp(size_t x, size_t unit) {
+            return (x + unit - 1) / unit * unit;
+        }
+
+        // address space only, pages are committed as they are touched
+        static Region Map(size_t size) {
+            size_t span = size + HUGE_PAGE;
+            void *p = mmap(nullptr, span, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (p == MAP_FAILED)
+                throw std::bad_alloc();
+            char *raw = static_cast<char *>(p);
+            char *base = reinterpret_cast<char *>(RoundUp(reinterpret_cast<size_t>(raw), HUGE_PAGE));
+            if (base != raw)
+                munmap(raw, base - raw);
+            if (base + size != raw + span)
+                munmap(base + size, raw + span - base - size);
+#ifdef MADV_HUGEPAGE
+            madvise(base, size, MADV_HUGEPAGE);
+#endif
+            return Region{base, size};
+        }
+
+        void Grow(size_t bytes) {
+            size_t size = RoundUp(bytes > next_size ? bytes : next_size, HUGE_PAGE);
+            Region r = Map(size);
+            try {
+                regions.push_back(r);
+            }
+            catch (...) {
+                munmap(r.base, r.size);
+                throw;
+            }
+            cursor = r.base;
+            limit = r.base + r.size;
+            next_size = size * 2;
+        }
+
+    public:
+        explicit huge_page_arena(size_t reserve = DEFAULT_RESERVE):cursor(nullptr), limit(nullptr),
+                live(0), next_size(reserve) {}
+
+        huge_page_arena(const huge_page_arena &other) = delete;
+        huge_page_arena & operator=(const huge_page_arena &other) = delete;
+
+        ~huge_page_arena() {
+            for (size_t i = 0; i < regions.size(); ++i)
+                munmap(regions[i].base, regions[i].size);
+        }
+
+        void *allocate(size_t bytes, size_t align) {
+            std::lock_guard<std::mutex> guard(lock);
+            for (size_t i = 0; i < spare.size(); ++i)
+                if (spare[i].bytes == bytes && reinterpret_cast<size_t>(spare[i].p) % align == 0) {
+                    void *res = spare[i].p;
+                    spare[i] = spare.back();
+                    spare.pop_back();
+                    ++live;
+                    return res;
+                }
+            char *p = reinterpret_cast<char *>(RoundUp(reinterpret_cast<size_t>(cursor), align));
+            if (!cursor || p > limit || size_t(limit - p) < bytes) {
+                Grow(bytes + align);
+                p = reinterpret_cast<char *>(RoundUp(reinterpret_cast<size_t>(cursor), align));
+            }
+            cursor = p + bytes;
+            ++live;
+            return p;
+        }
+
+        // once nothing is live the newest (largest) region is reused from
+        // its start and older ones are unmapped
+        void deallocate(void *p, size_t bytes) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (--live) {
+                try {
+                    spare.push_back(Chunk{p, bytes});
+                }
+                catch (...) {} // the chunk comes back with the next trim
+                return;
+            }
+            spare.clear();
+            for (size_t i = 0; i + 1 < regions.size(); ++i)
+                munmap(regions[i].base, regions[i].size);
+            regions.erase(regions.begin(), regions.end() - 1);
+            cursor = regions.back().base;
+            limit = cursor + regions.back().size;
+        }
+
+        // mapped address space, committed or not
+        size_t capacity() {
+            std::lock_guard<std::mutex> guard(lock);
+            size_t res = 0;
+            for (size_t i = 0; i < regions.size(); ++i)
+                res += regions[i].size;
+            return res;
+        }
+    };
+
+    // allocator over a shared huge_page_arena, copies and rebinds share it;
+    // e.g. map<Key, Value, Compare, huge_page_allocator<pair<const Key, Value>>>
+    template<class T>
+    class huge_page_allocator {
+        template<class U> friend class huge_page_allocator;
+
+    private:
+        std::shared_ptr<huge_page_arena> arena;
+
+    public:
+        typedef T value_type;
+
+        // reserve is the address space mapped first, in bytes
+        explicit huge_page_allocator(size_t reserve = huge_page_arena::DEFAULT_RESERVE):
+                arena(std::make_shared<huge_page_arena>(reserve)) {}
+
+        template<class U>
+        huge_page_allocator(const huge_page_allocator<U> &other):arena(other.arena) {}
+
+        T *allocate(size_t k) {
+            return static_cast<T *>(arena->allocate(k * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *p, size_t k) {
+            arena->deallocate(p, k * sizeof(T));
+        }
+
+        size_t capacity() const {
+            return arena->capacity();
+        }
+
+        template<class U>
+        bool operator==(const huge_page_allocator<U> &other) const {
+            return arena == other.arena;
+        }
+
+        template<class U>
+        bool operator!=(const huge_page_allocator<U> &other) const {
+            return arena != other.arena;
+        }
+    };
+}
+
+#endif
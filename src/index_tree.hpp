@@ -0,0 +1,762 @@
+#ifndef SJTU_INDEX_TREE_HPP
+#define SJTU_INDEX_TREE_HPP
+
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+    // a node linked by slot numbers instead of pointers: the color is the
+    // low bit of the parent link and slot 0 is the shared black leaf
+    template<class Index, class T>
+    class index_node {
+    public:
+        Index child[2];
+        Index link; // fa << 1 | red
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T *Package() {
+            return reinterpret_cast<T *>(storage);
+        }
+
+        const T *Package() const {
+            return reinterpret_cast<const T *>(storage);
+        }
+    };
+
+    // slots on the heap with 32-bit indices: chunk k holds slots
+    // [2^(k+4) - 16, 2^(k+5) - 16), so the slab grows geometrically, never
+    // moves a node and an index maps to its chunk with one bit scan
+    template<class T>
+    class index_slab {
+    public:
+        typedef uint32_t Index;
+        typedef index_node<Index, T> Node;
+
+    private:
+        static const int FIRST_BITS = 4;
+        static const int CHUNKS = 28;
+        static const Index MAX_SLOT = ((Index)1 << 31) - 1;
+
+        Node *chunks[CHUNKS];
+        Index top, free_list;
+
+        static int HighBit(Index x) {
+#if defined(__GNUC__)
+            return 31 - __builtin_clz(x);
+#else
+            int res = 0;
+            while (x >>= 1)
+                ++res;
+            return res;
+#endif
+        }
+
+        size_t Chunks() const {
+            return top ? HighBit(top - 1 + (1u << FIRST_BITS)) - FIRST_BITS + 1 : 0;
+        }
+
+    public:
+        index_slab():top(0), free_list(0) {}
+
+        index_slab(const index_slab &) = delete;
+
+        index_slab & operator=(const index_slab &) = delete;
+
+        Node &operator[](Index x) const {
+            Index j = x + (1u << FIRST_BITS);
+            int k = HighBit(j) - FIRST_BITS;
+            return chunks[k][j - (1u << (k + FIRST_BITS))];
+        }
+
+        // slot 0 is the black leaf, it is laid out with the first chunk
+        Index allocate() {
+            Index x;
+            if (free_list) {
+                x = free_list;
+                free_list = (*this)[x].child[0];
+                return x;
+            }
+            if (top == MAX_SLOT)
+                throw runtime_error();
+            Index j = top + (1u << FIRST_BITS);
+            if (!(j & (j - 1))) {
+                int k = HighBit(j) - FIRST_BITS;
+                chunks[k] = static_cast<Node *>(::operator new(sizeof(Node) * ((size_t)1 << (k + FIRST_BITS))));
+            }
+            if (!top) {
+                Node &leaf = *new (chunks[0]) Node;
+                leaf.child[0] = leaf.child[1] = leaf.link = 0;
+                top = 1;
+                return allocate();
+            }
+            return top++;
+        }
+
+        void deallocate(Index x) {
+            (*this)[x].child[0] = free_list;
+            free_list = x;
+        }
+
+        // every package must already be destroyed
+        void release() {
+            for (size_t k = 0, size = Chunks(); k < size; ++k)
+                ::operator delete(chunks[k]);
+            top = free_list = 0;
+        }
+
+        // same slots as other, with the links (whole nodes when whole is
+        // set) copied over; called on an empty slab
+        void copy_links(const index_slab &other, bool whole) {
+            for (size_t k = 0, size = other.Chunks(); k < size; ++k) {
+                size_t slots = (size_t)1 << (k + FIRST_BITS), start = slots - (1u << FIRST_BITS);
+                size_t used = other.top - start < slots ? other.top - start : slots;
+                chunks[k] = static_cast<Node *>(::operator new(sizeof(Node) * slots));
+                if (whole)
+                    std::memcpy(static_cast<void *>(chunks[k]), other.chunks[k], sizeof(Node) * used);
+                else
+                    for (size_t i = 0; i < used; ++i) {
+                        Node &a = *new (chunks[k] + i) Node;
+                        std::memcpy(a.child, other.chunks[k][i].child, sizeof(a.child));
+                        a.link = other.chunks[k][i].link;
+                    }
+            }
+            top = other.top;
+            free_list = other.free_list;
+        }
+    };
+
+    // N slots (plus the leaf) inside the object, with 16-bit indices when N
+    // allows; taking one more throws runtime_error
+    template<class T, size_t N>
+    class index_array {
+    public:
+        typedef typename std::conditional<(N < 0x7fff), uint16_t, uint32_t>::type Index;
+        typedef index_node<Index, T> Node;
+
+        static_assert(N < 0x7fffffff, "index_array capacity must fit a 31-bit index");
+
+    private:
+        Node nodes[N + 1];
+        Index top, free_list;
+
+        // the delete fixup may set the leaf's parent
+        void Leaf() {
+            Node &leaf = *new (nodes) Node;
+            leaf.child[0] = leaf.child[1] = leaf.link = 0;
+        }
+
+    public:
+        index_array():top(1), free_list(0) {
+            Leaf();
+        }
+
+        index_array(const index_array &) = delete;
+
+        index_array & operator=(const index_array &) = delete;
+
+        Node &operator[](Index x) {
+            return nodes[x];
+        }
+
+        const Node &operator[](Index x) const {
+            return nodes[x];
+        }
+
+        Index allocate() {
+            Index x;
+            if (free_list) {
+                x = free_list;
+                free_list = nodes[x].child[0];
+                return x;
+            }
+            if (top == N + 1)
+                throw runtime_error();
+            return top++;
+        }
+
+        void deallocate(Index x) {
+            nodes[x].child[0] = free_list;
+            free_list = x;
+        }
+
+        void release() {
+            top = 1;
+            free_list = 0;
+        }
+
+        void copy_links(const index_array &other, bool whole) {
+            if (whole)
+                std::memcpy(static_cast<void *>(nodes), other.nodes, sizeof(Node) * other.top);
+            else
+                for (Index i = 0; i < other.top; ++i) {
+                    std::memcpy(nodes[i].child, other.nodes[i].child, sizeof(nodes[i].child));
+                    nodes[i].link = other.nodes[i].link;
+                }
+            top = other.top;
+            free_list = other.free_list;
+        }
+    };
+
+    // the red-black map compact_map and static_map share, over slots from
+    // Slots (index_slab or index_array) linked by index; an index stays
+    // put for the life of its element, so a copy keeps every index and
+    // only the packages need care
+    template<
+            class Key,
+            class Value,
+            class Compare,
+            class Slots
+    > class index_tree {
+    public:
+        typedef pair<const Key, Value> value_type;
+
+    protected:
+        typedef typename Slots::Index Index;
+        typedef typename Slots::Node Node;
+
+        Compare comp;
+        Slots slots;
+        Index root;
+        size_t n;
+
+        Node &At(Index x) {
+            return slots[x];
+        }
+
+        const Node &At(Index x) const {
+            return slots[x];
+        }
+
+        Index Fa(Index x) const {
+            return At(x).link >> 1;
+        }
+
+        void SetFa(Index x, Index y) {
+            Node &a = At(x);
+            a.link = y << 1 | (a.link & 1);
+        }
+
+        bool Red(Index x) const {
+            return At(x).link & 1;
+        }
+
+        void SetRed(Index x, bool red) {
+            Node &a = At(x);
+            a.link = (a.link & ~1u) | red;
+        }
+
+        Index &Child(Index x, int c) {
+            return At(x).child[c];
+        }
+
+        Index Child(Index x, int c) const {
+            return At(x).child[c];
+        }
+
+        const Key &KeyOf(Index x) const {
+            return At(x).Package()->first;
+        }
+
+        Index NewNode(const Key &key, const Value &value) {
+            Index x = slots.allocate();
+            Node &a = *new (&At(x)) Node;
+            try {
+                new (a.storage) value_type(key, value);
+            }
+            catch (...) {
+                slots.deallocate(x);
+                throw;
+            }
+            a.child[0] = a.child[1] = 0;
+            a.link = 1;
+            return x;
+        }
+
+        void DeleteNode(Index x) {
+            At(x).Package()->~value_type();
+            slots.deallocate(x);
+        }
+
+        // lifts x's child[c] above x
+        void Rotate(Index x, int c) {
+            Index y = Child(x, c), w = Fa(x), b = Child(y, !c);
+            Child(x, c) = b;
+            if (b)
+                SetFa(b, x);
+            SetFa(y, w);
+            if (!w)
+                root = y;
+            else
+                Child(w, Child(w, 1) == x) = y;
+            Child(y, !c) = x;
+            SetFa(x, y);
+        }
+
+        Index Insert(const Key &key, const Value &value, bool &found) {
+            Index x = root, y = 0;
+            int c = 0;
+            while (x) {
+                const Key &k = KeyOf(x);
+                bool less = comp(key, k);
+                if (!less && !comp(k, key)) {
+                    found = true;
+                    return x;
+                }
+                y = x;
+                c = less;
+                x = Child(x, c);
+            }
+            found = false;
+            Index z = NewNode(key, value), res = z;
+            SetFa(z, y);
+            if (!y)
+                root = z;
+            else
+                Child(y, c) = z;
+            ++n;
+            while (Red(Fa(z))) {
+                Index p = Fa(z), g = Fa(p);
+                int s = Child(g, 1) == p;
+                Index u = Child(g, !s);
+                if (Red(u)) {
+                    SetRed(p, false);
+                    SetRed(u, false);
+                    SetRed(g, true);
+                    z = g;
+                }
+                else {
+                    if (z == Child(p, !s)) {
+                        z = p;
+                        Rotate(z, !s);
+                        p = Fa(z);
+                    }
+                    SetRed(p, false);
+                    SetRed(g, true);
+                    Rotate(g, s);
+                }
+            }
+            SetRed(root, false);
+            return res;
+        }
+
+        // the leaf's parent is set on purpose so the fixup can climb from it
+        void Transplant(Index u, Index v) {
+            Index p = Fa(u);
+            if (!p)
+                root = v;
+            else
+                Child(p, Child(p, 1) == u) = v;
+            SetFa(v, p);
+        }
+
+        void Delete(Index z) {
+            Index y = z, x;
+            bool red = Red(y);
+            if (!Child(z, 0)) {
+                x = Child(z, 1);
+                Transplant(z, x);
+            }
+            else if (!Child(z, 1)) {
+                x = Child(z, 0);
+                Transplant(z, x);
+            }
+            else {
+                y = Child(z, 0);
+                while (Child(y, 1))
+                    y = Child(y, 1);
+                red = Red(y);
+                x = Child(y, 0);
+                if (Fa(y) == z)
+                    SetFa(x, y);
+                else {
+                    Transplant(y, x);
+                    Child(y, 0) = Child(z, 0);
+                    SetFa(Child(y, 0), y);
+                }
+                Transplant(z, y);
+                Child(y, 1) = Child(z, 1);
+                SetFa(Child(y, 1), y);
+                SetRed(y, Red(z));
+            }
+            if (!red) {
+                while (x != root && !Red(x)) {
+                    Index p = Fa(x);
+                    int s = Child(p, 1) == x;
+                    Index w = Child(p, !s);
+                    if (Red(w)) {
+                        SetRed(w, false);
+                        SetRed(p, true);
+                        Rotate(p, !s);
+                        w = Child(p, !s);
+                    }
+                    if (!Red(Child(w, 0)) && !Red(Child(w, 1))) {
+                        SetRed(w, true);
+                        x = p;
+                    }
+                    else {
+                        if (!Red(Child(w, !s))) {
+                            SetRed(Child(w, s), false);
+                            SetRed(w, true);
+                            Rotate(w, s);
+                            w = Child(p, !s);
+                        }
+                        SetRed(w, Red(p));
+                        SetRed(p, false);
+                        SetRed(Child(w, !s), false);
+                        Rotate(p, !s);
+                        x = root;
+                    }
+                }
+                SetRed(x, false);
+            }
+            DeleteNode(z);
+            --n;
+        }
+
+        Index Find(const Key &key) const {
+            Index x = root;
+            while (x) {
+                const Key &k = KeyOf(x);
+                bool less = comp(key, k);
+                if (!less && !comp(k, key))
+                    return x;
+                x = Child(x, less);
+            }
+            return 0;
+        }
+
+        // c = 1 steps to the next larger key, c = 0 to the next smaller
+        Index Move(Index x, int c) const {
+            if (Child(x, !c)) {
+                x = Child(x, !c);
+                while (Child(x, c))
+                    x = Child(x, c);
+                return x;
+            }
+            Index y = Fa(x);
+            while (y && Child(y, !c) == x) {
+                x = y;
+                y = Fa(y);
+            }
+            return y;
+        }
+
+        Index Edge(int c) const {
+            Index x = root;
+            if (!x)
+                return 0;
+            while (Child(x, c))
+                x = Child(x, c);
+            return x;
+        }
+
+        // rotates child[1] up until the top has none, then drops it
+        void Destruct() {
+            if (!std::is_trivially_destructible<value_type>::value) {
+                Index rest = root;
+                while (rest) {
+                    Index x = rest, y = Child(x, 1);
+                    if (y) {
+                        Child(x, 1) = Child(y, 0);
+                        Child(y, 0) = x;
+                        rest = y;
+                    }
+                    else {
+                        rest = Child(x, 0);
+                        At(x).Package()->~value_type();
+                    }
+                }
+            }
+            slots.release();
+            root = 0;
+            n = 0;
+        }
+
+        void Copy(const index_tree &other) {
+            slots.copy_links(other.slots, std::is_trivially_copyable<value_type>::value);
+            if (std::is_trivially_copyable<value_type>::value) {
+                root = other.root;
+                n = other.n;
+                return;
+            }
+            Index stack[64], x;
+            int depth = 0;
+            size_t k = 0;
+            try {
+                if (other.root)
+                    stack[depth++] = other.root;
+                while (depth) {
+                    x = stack[--depth];
+                    new (At(x).storage) value_type(*other.At(x).Package());
+                    ++k;
+                    if (Child(x, 0))
+                        stack[depth++] = Child(x, 0);
+                    if (Child(x, 1))
+                        stack[depth++] = Child(x, 1);
+                }
+            }
+            catch (...) {
+                depth = 0;
+                stack[depth++] = other.root;
+                for (; k; --k) {
+                    x = stack[--depth];
+                    At(x).Package()->~value_type();
+                    if (Child(x, 0))
+                        stack[depth++] = Child(x, 0);
+                    if (Child(x, 1))
+                        stack[depth++] = Child(x, 1);
+                }
+                root = 0;
+                Destruct();
+                throw;
+            }
+            root = other.root;
+            n = other.n;
+        }
+
+    public:
+        class const_iterator;
+        class iterator {
+        private:
+            Index ptr;
+            index_tree *source;
+
+            friend index_tree;
+
+            iterator(Index ptr, index_tree *source):ptr(ptr), source(source) {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = Value;
+            using pointer = Value*;
+            using reference = Value&;
+            using iterator_category = std::output_iterator_tag;
+            using iterator_assignable = my_true_type;
+
+            iterator():ptr(0), source(nullptr) {}
+
+            iterator operator++(int) {
+                iterator res = *this;
+                operator++();
+                return res;
+            }
+
+            iterator & operator++() {
+                if (!ptr)
+                    throw invalid_iterator();
+                ptr = source->Move(ptr, 1);
+                return *this;
+            }
+
+            iterator operator--(int) {
+                iterator res = *this;
+                operator--();
+                return res;
+            }
+
+            iterator & operator--() {
+                ptr = ptr ? source->Move(ptr, 0) : source->Edge(0);
+                if (!ptr)
+                    throw invalid_iterator();
+                return *this;
+            }
+
+            index_tree::value_type & operator*() const {
+                return *source->At(ptr).Package();
+            }
+
+            index_tree::value_type* operator->() const noexcept {
+                return source->At(ptr).Package();
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return ptr == rhs.ptr && source == rhs.source;
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return ptr == rhs.ptr && source == rhs.source;
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return !(*this == rhs);
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return !(*this == rhs);
+            }
+        };
+        class const_iterator {
+        private:
+            Index ptr;
+            const index_tree *source;
+
+            friend index_tree;
+
+            const_iterator(Index ptr, const index_tree *source):ptr(ptr), source(source) {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = Value;
+            using pointer = Value*;
+            using reference = Value&;
+            using iterator_category = std::output_iterator_tag;
+            using iterator_assignable = my_false_type;
+
+            const_iterator():ptr(0), source(nullptr) {}
+
+            const_iterator(const iterator &other):ptr(other.ptr), source(other.source) {}
+
+            const_iterator operator++(int) {
+                const_iterator res = *this;
+                operator++();
+                return res;
+            }
+
+            const_iterator & operator++() {
+                if (!ptr)
+                    throw invalid_iterator();
+                ptr = source->Move(ptr, 1);
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator res = *this;
+                operator--();
+                return res;
+            }
+
+            const_iterator & operator--() {
+                ptr = ptr ? source->Move(ptr, 0) : source->Edge(0);
+                if (!ptr)
+                    throw invalid_iterator();
+                return *this;
+            }
+
+            const index_tree::value_type & operator*() const {
+                return *source->At(ptr).Package();
+            }
+
+            const index_tree::value_type* operator->() const noexcept {
+                return source->At(ptr).Package();
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return ptr == rhs.ptr && source == rhs.source;
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return ptr == rhs.ptr && source == rhs.source;
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return !(*this == rhs);
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return !(*this == rhs);
+            }
+        };
+
+        index_tree():root(0), n(0) {}
+
+        index_tree(const index_tree &other):comp(other.comp), root(0), n(0) {
+            Copy(other);
+        }
+
+        index_tree & operator=(const index_tree &other) {
+            if (this == &other)
+                return *this;
+            Destruct();
+            Copy(other);
+            return *this;
+        }
+
+        ~index_tree() {
+            Destruct();
+        }
+
+        Value & at(const Key &key) {
+            Index x = Find(key);
+            if (!x)
+                throw index_out_of_bound();
+            return At(x).Package()->second;
+        }
+
+        const Value & at(const Key &key) const {
+            Index x = Find(key);
+            if (!x)
+                throw index_out_of_bound();
+            return At(x).Package()->second;
+        }
+
+        Value & operator[](const Key &key) {
+            bool found;
+            return At(Insert(key, Value(), found)).Package()->second;
+        }
+
+        const Value & operator[](const Key &key) const {
+            return at(key);
+        }
+
+        iterator begin() {
+            return iterator(Edge(1), this);
+        }
+
+        const_iterator cbegin() const {
+            return const_iterator(Edge(1), this);
+        }
+
+        iterator end() {
+            return iterator(0, this);
+        }
+
+        const_iterator cend() const {
+            return const_iterator(0, this);
+        }
+
+        bool empty() const {
+            return !n;
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        void clear() {
+            Destruct();
+        }
+
+        pair<iterator, bool> insert(const value_type &value) {
+            bool found;
+            Index x = Insert(value.first, value.second, found);
+            return pair<iterator, bool>(iterator(x, this), !found);
+        }
+
+        void erase(iterator pos) {
+            if (pos.source != this || !pos.ptr)
+                throw invalid_iterator();
+            Delete(pos.ptr);
+        }
+
+        size_t count(const Key &key) const {
+            return Find(key) != 0;
+        }
+
+        iterator find(const Key &key) {
+            return iterator(Find(key), this);
+        }
+
+        const_iterator find(const Key &key) const {
+            return const_iterator(Find(key), this);
+        }
+    };
+}
+
+#endif
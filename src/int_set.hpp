@@ -0,0 +1,792 @@
+#ifndef SJTU_INT_SET_HPP
+#define SJTU_INT_SET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace sjtu {
+    // ordered set of ints as a roaring bitmap: the high 16 bits of a value
+    // pick a container and the low 16 bits are stored in it, as a sorted
+    // array while it holds at most 4096 values, as a 65536-bit bitmap past
+    // that, or as runs of consecutive values once optimize() finds those
+    // smaller; a dense set costs about one bit per value, a sparse one two
+    // bytes. Iterators hold a position, not a pointer, and any insert or
+    // erase invalidates them
+    class int_set {
+    public:
+        typedef int value_type;
+
+    private:
+        enum Type {ARRAY, BITMAP, RUN};
+
+        static const uint32_t ARRAY_MAX = 4096;
+        static const uint32_t WORDS = 1024;
+        static const uint32_t MAX_RUNS = 2048; // a run costs 4 bytes, a bitmap 8K
+
+        struct Container {
+            uint8_t type;
+            uint32_t card;
+            std::vector<uint16_t> data; // the values, or start, length - 1 pairs for runs
+            std::vector<uint64_t> bits;
+
+            Container():type(ARRAY), card(0) {}
+        };
+
+        std::vector<uint16_t> keys; // the high halves, ascending
+        std::vector<Container> containers;
+        size_t n;
+
+        static uint32_t Encode(int x) {
+            return (uint32_t)x ^ 0x80000000u;
+        }
+
+        static int Decode(uint32_t high, uint32_t low) {
+            return (int)((high << 16 | low) ^ 0x80000000u);
+        }
+
+        static uint32_t Popcount(const uint64_t *w) {
+            uint32_t res = 0;
+            for (uint32_t i = 0; i < WORDS; ++i)
+                res += __builtin_popcountll(w[i]);
+            return res;
+        }
+
+        // dst &= src (both) or dst |= src over a whole bitmap, returns the
+        // number of bits left in dst
+        static uint32_t Merge(uint64_t *dst, const uint64_t *src, bool both) {
+#if defined(__AVX2__)
+            for (uint32_t i = 0; i < WORDS; i += 4) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+                __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                                    both ? _mm256_and_si256(x, y) : _mm256_or_si256(x, y));
+            }
+#elif defined(__SSE2__)
+            for (uint32_t i = 0; i < WORDS; i += 2) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+                __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                                 both ? _mm_and_si128(x, y) : _mm_or_si128(x, y));
+            }
+#else
+            for (uint32_t i = 0; i < WORDS; ++i)
+                dst[i] = both ? dst[i] & src[i] : dst[i] | src[i];
+#endif
+            return Popcount(dst);
+        }
+
+        static uint32_t Runs(const Container &c) {
+            return c.data.size() / 2;
+        }
+
+        static uint32_t RunEnd(const Container &c, uint32_t r) {
+            return (uint32_t)c.data[2 * r] + c.data[2 * r + 1];
+        }
+
+        // the last run starting at or below low, -1 if there is none
+        static long FindRun(const Container &c, uint32_t low) {
+            long lo = 0, hi = Runs(c);
+            while (lo < hi) {
+                long mid = (lo + hi) / 2;
+                if (c.data[2 * mid] <= low)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo - 1;
+        }
+
+        static void SetRange(uint64_t *w, uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i <= last; ) {
+                if (!(i & 63) && i + 63 <= last) {
+                    w[i >> 6] = ~0ull;
+                    i += 64;
+                }
+                else {
+                    w[i >> 6] |= 1ull << (i & 63);
+                    ++i;
+                }
+            }
+        }
+
+        static void ToBitmap(Container &c) {
+            std::vector<uint64_t> bits(WORDS);
+            if (c.type == ARRAY)
+                for (size_t i = 0; i < c.data.size(); ++i)
+                    bits[c.data[i] >> 6] |= 1ull << (c.data[i] & 63);
+            else
+                for (uint32_t r = 0; r < Runs(c); ++r)
+                    SetRange(bits.data(), c.data[2 * r], RunEnd(c, r));
+            c.bits.swap(bits);
+            std::vector<uint16_t>().swap(c.data);
+            c.type = BITMAP;
+        }
+
+        static void ToArray(Container &c) {
+            std::vector<uint16_t> data;
+            data.reserve(c.card);
+            uint32_t k = 0, low = 0;
+            for (bool ok = Seek(c, 0, k, low); ok; ok = Step(c, k, low))
+                data.push_back(low);
+            c.data.swap(data);
+            std::vector<uint64_t>().swap(c.bits);
+            c.type = ARRAY;
+        }
+
+        static void ToRun(Container &c) {
+            std::vector<uint16_t> data;
+            uint32_t k = 0, low = 0;
+            for (bool ok = Seek(c, 0, k, low); ok; ok = Step(c, k, low))
+                if (!data.empty() && (uint32_t)data[data.size() - 2] + data.back() + 1 == low)
+                    ++data.back();
+                else {
+                    data.push_back(low);
+                    data.push_back(0);
+                }
+            c.data.swap(data);
+            std::vector<uint64_t>().swap(c.bits);
+            c.type = RUN;
+        }
+
+        static uint32_t CountRuns(const Container &c) {
+            if (c.type == RUN)
+                return Runs(c);
+            uint32_t res = 0;
+            if (c.type == ARRAY) {
+                for (size_t i = 0; i < c.data.size(); ++i)
+                    res += !i || c.data[i - 1] + 1 != c.data[i];
+                return res;
+            }
+            // a run starts at each set bit whose lower neighbour is clear
+            uint64_t carry = 0;
+            for (uint32_t i = 0; i < WORDS; ++i) {
+                res += __builtin_popcountll(c.bits[i] & ~(c.bits[i] << 1 | carry));
+                carry = c.bits[i] >> 63;
+            }
+            return res;
+        }
+
+        static bool Contains(const Container &c, uint32_t low) {
+            switch (c.type) {
+                case ARRAY:
+                    return std::binary_search(c.data.begin(), c.data.end(), (uint16_t)low);
+                case BITMAP:
+                    return c.bits[low >> 6] >> (low & 63) & 1;
+                default: {
+                    long r = FindRun(c, low);
+                    return r >= 0 && low <= RunEnd(c, r);
+                }
+            }
+        }
+
+        static bool Add(Container &c, uint32_t low) {
+            switch (c.type) {
+                case ARRAY: {
+                    std::vector<uint16_t>::iterator it = std::lower_bound(c.data.begin(), c.data.end(), (uint16_t)low);
+                    if (it != c.data.end() && *it == low)
+                        return false;
+                    if (c.card == ARRAY_MAX) {
+                        ToBitmap(c);
+                        return Add(c, low);
+                    }
+                    c.data.insert(it, (uint16_t)low);
+                    break;
+                }
+                case BITMAP: {
+                    uint64_t &w = c.bits[low >> 6], bit = 1ull << (low & 63);
+                    if (w & bit)
+                        return false;
+                    w |= bit;
+                    break;
+                }
+                default: {
+                    long r = FindRun(c, low);
+                    if (r >= 0 && low <= RunEnd(c, r))
+                        return false;
+                    bool left = r >= 0 && RunEnd(c, r) + 1 == low;
+                    bool right = r + 1 < (long)Runs(c) && c.data[2 * r + 2] == low + 1;
+                    if (left && right) {
+                        c.data[2 * r + 1] = RunEnd(c, r + 1) - c.data[2 * r];
+                        c.data.erase(c.data.begin() + 2 * r + 2, c.data.begin() + 2 * r + 4);
+                    }
+                    else if (left)
+                        ++c.data[2 * r + 1];
+                    else if (right) {
+                        --c.data[2 * r + 2];
+                        ++c.data[2 * r + 3];
+                    }
+                    else {
+                        uint16_t run[2] = {(uint16_t)low, 0};
+                        c.data.insert(c.data.begin() + 2 * (r + 1), run, run + 2);
+                    }
+                    ++c.card;
+                    if (Runs(c) > MAX_RUNS)
+                        ToBitmap(c);
+                    return true;
+                }
+            }
+            ++c.card;
+            return true;
+        }
+
+        static bool Remove(Container &c, uint32_t low) {
+            switch (c.type) {
+                case ARRAY: {
+                    std::vector<uint16_t>::iterator it = std::lower_bound(c.data.begin(), c.data.end(), (uint16_t)low);
+                    if (it == c.data.end() || *it != low)
+                        return false;
+                    c.data.erase(it);
+                    --c.card;
+                    return true;
+                }
+                case BITMAP: {
+                    uint64_t &w = c.bits[low >> 6], bit = 1ull << (low & 63);
+                    if (!(w & bit))
+                        return false;
+                    w &= ~bit;
+                    if (--c.card <= ARRAY_MAX)
+                        ToArray(c);
+                    return true;
+                }
+                default: {
+                    long r = FindRun(c, low);
+                    if (r < 0 || low > RunEnd(c, r))
+                        return false;
+                    uint32_t first = c.data[2 * r], last = RunEnd(c, r);
+                    if (first == last)
+                        c.data.erase(c.data.begin() + 2 * r, c.data.begin() + 2 * r + 2);
+                    else if (low == first) {
+                        ++c.data[2 * r];
+                        --c.data[2 * r + 1];
+                    }
+                    else if (low == last)
+                        --c.data[2 * r + 1];
+                    else {
+                        c.data[2 * r + 1] = low - 1 - first;
+                        uint16_t run[2] = {(uint16_t)(low + 1), (uint16_t)(last - low - 1)};
+                        c.data.insert(c.data.begin() + 2 * (r + 1), run, run + 2);
+                    }
+                    --c.card;
+                    if (Runs(c) > MAX_RUNS)
+                        ToBitmap(c);
+                    return true;
+                }
+            }
+        }
+
+        // how many values of c are below low
+        static uint32_t Rank(const Container &c, uint32_t low) {
+            switch (c.type) {
+                case ARRAY:
+                    return std::lower_bound(c.data.begin(), c.data.end(), (uint16_t)low) - c.data.begin();
+                case BITMAP: {
+                    uint32_t res = 0;
+                    for (uint32_t i = 0; i < (low >> 6); ++i)
+                        res += __builtin_popcountll(c.bits[i]);
+                    if (low & 63)
+                        res += __builtin_popcountll(c.bits[low >> 6] & ((1ull << (low & 63)) - 1));
+                    return res;
+                }
+                default: {
+                    uint32_t res = 0;
+                    for (uint32_t r = 0; r < Runs(c) && c.data[2 * r] < low; ++r)
+                        res += std::min(RunEnd(c, r), low - 1) - c.data[2 * r] + 1;
+                    return res;
+                }
+            }
+        }
+
+        // the value of c with rank k, k < c.card
+        static uint32_t Select(const Container &c, uint32_t k) {
+            switch (c.type) {
+                case ARRAY:
+                    return c.data[k];
+                case BITMAP: {
+                    uint32_t i = 0;
+                    for (uint32_t cnt; (cnt = __builtin_popcountll(c.bits[i])) <= k; ++i)
+                        k -= cnt;
+                    uint64_t w = c.bits[i];
+                    for (; k; --k)
+                        w &= w - 1;
+                    return i << 6 | __builtin_ctzll(w);
+                }
+                default: {
+                    uint32_t r = 0;
+                    for (; c.data[2 * r + 1] < k; ++r)
+                        k -= c.data[2 * r + 1] + 1;
+                    return c.data[2 * r] + k;
+                }
+            }
+        }
+
+        // moves (k, low) to the first value of c at or above from; k is the
+        // array index or run number that makes Step and Back O(1)
+        static bool Seek(const Container &c, uint32_t from, uint32_t &k, uint32_t &low) {
+            if (from > 0xffff)
+                return false;
+            switch (c.type) {
+                case ARRAY:
+                    k = std::lower_bound(c.data.begin(), c.data.end(), (uint16_t)from) - c.data.begin();
+                    if (k == c.data.size())
+                        return false;
+                    low = c.data[k];
+                    return true;
+                case BITMAP: {
+                    uint32_t i = from >> 6;
+                    uint64_t w = c.bits[i] & (~0ull << (from & 63));
+                    k = 0;
+                    while (!w) {
+                        if (++i == WORDS)
+                            return false;
+                        w = c.bits[i];
+                    }
+                    low = i << 6 | __builtin_ctzll(w);
+                    return true;
+                }
+                default: {
+                    long r = FindRun(c, from);
+                    if (r >= 0 && from <= RunEnd(c, r)) {
+                        k = r;
+                        low = from;
+                        return true;
+                    }
+                    if (r + 1 == (long)Runs(c))
+                        return false;
+                    k = r + 1;
+                    low = c.data[2 * k];
+                    return true;
+                }
+            }
+        }
+
+        // moves (k, low) to the last value of c at or below from
+        static bool SeekBack(const Container &c, uint32_t from, uint32_t &k, uint32_t &low) {
+            switch (c.type) {
+                case ARRAY:
+                    k = std::upper_bound(c.data.begin(), c.data.end(), (uint16_t)from) - c.data.begin();
+                    if (!k)
+                        return false;
+                    low = c.data[--k];
+                    return true;
+                case BITMAP: {
+                    uint32_t i = from >> 6;
+                    uint64_t w = c.bits[i] & (~0ull >> (63 - (from & 63)));
+                    k = 0;
+                    while (!w) {
+                        if (!i--)
+                            return false;
+                        w = c.bits[i];
+                    }
+                    low = i << 6 | (63 - __builtin_clzll(w));
+                    return true;
+                }
+                default: {
+                    long r = FindRun(c, from);
+                    if (r < 0)
+                        return false;
+                    k = r;
+                    low = std::min(from, RunEnd(c, r));
+                    return true;
+                }
+            }
+        }
+
+        static bool Step(const Container &c, uint32_t &k, uint32_t &low) {
+            switch (c.type) {
+                case ARRAY:
+                    if (k + 1 == c.data.size())
+                        return false;
+                    low = c.data[++k];
+                    return true;
+                case BITMAP:
+                    return Seek(c, low + 1, k, low);
+                default:
+                    if (low < RunEnd(c, k)) {
+                        ++low;
+                        return true;
+                    }
+                    if (k + 1 == Runs(c))
+                        return false;
+                    low = c.data[2 * ++k];
+                    return true;
+            }
+        }
+
+        static bool Back(const Container &c, uint32_t &k, uint32_t &low) {
+            switch (c.type) {
+                case ARRAY:
+                    if (!k)
+                        return false;
+                    low = c.data[--k];
+                    return true;
+                case BITMAP:
+                    return low && SeekBack(c, low - 1, k, low);
+                default:
+                    if (low > c.data[2 * k]) {
+                        --low;
+                        return true;
+                    }
+                    if (!k)
+                        return false;
+                    low = RunEnd(c, --k);
+                    return true;
+            }
+        }
+
+        static void Unite(Container &a, const Container &b) {
+            if (a.type == ARRAY && b.type == ARRAY) {
+                std::vector<uint16_t> data(a.data.size() + b.data.size());
+                data.resize(std::set_union(a.data.begin(), a.data.end(), b.data.begin(), b.data.end(),
+                                           data.begin()) - data.begin());
+                a.data.swap(data);
+                a.card = a.data.size();
+                if (a.card > ARRAY_MAX)
+                    ToBitmap(a);
+                return;
+            }
+            if (a.type != BITMAP)
+                ToBitmap(a);
+            if (b.type == BITMAP)
+                a.card = Merge(a.bits.data(), b.bits.data(), false);
+            else {
+                if (b.type == ARRAY)
+                    for (size_t i = 0; i < b.data.size(); ++i)
+                        a.bits[b.data[i] >> 6] |= 1ull << (b.data[i] & 63);
+                else
+                    for (uint32_t r = 0; r < Runs(b); ++r)
+                        SetRange(a.bits.data(), b.data[2 * r], RunEnd(b, r));
+                a.card = Popcount(a.bits.data());
+            }
+            if (a.card <= ARRAY_MAX)
+                ToArray(a);
+        }
+
+        static void Intersect(Container &a, const Container &b) {
+            if (a.type == ARRAY || b.type == ARRAY) {
+                std::vector<uint16_t> data;
+                if (a.type == ARRAY && b.type == ARRAY) {
+                    data.resize(std::min(a.data.size(), b.data.size()));
+                    data.resize(std::set_intersection(a.data.begin(), a.data.end(), b.data.begin(), b.data.end(),
+                                                      data.begin()) - data.begin());
+                }
+                else {
+                    const Container &array = a.type == ARRAY ? a : b, &other = a.type == ARRAY ? b : a;
+                    for (size_t i = 0; i < array.data.size(); ++i)
+                        if (Contains(other, array.data[i]))
+                            data.push_back(array.data[i]);
+                }
+                a.data.swap(data);
+                std::vector<uint64_t>().swap(a.bits);
+                a.type = ARRAY;
+                a.card = a.data.size();
+                return;
+            }
+            if (a.type != BITMAP)
+                ToBitmap(a);
+            if (b.type == BITMAP)
+                a.card = Merge(a.bits.data(), b.bits.data(), true);
+            else {
+                Container mask = b;
+                ToBitmap(mask);
+                a.card = Merge(a.bits.data(), mask.bits.data(), true);
+            }
+            if (a.card <= ARRAY_MAX)
+                ToArray(a);
+        }
+
+        size_t FindKey(uint32_t high) const {
+            return std::lower_bound(keys.begin(), keys.end(), (uint16_t)high) - keys.begin();
+        }
+
+    public:
+        class const_iterator {
+        private:
+            const int_set *source;
+            size_t i;
+            uint32_t k;
+            int value;
+
+            friend int_set;
+
+            const_iterator(const int_set *source, size_t i, uint32_t k, int value):
+                    source(source), i(i), k(k), value(value) {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = int;
+            using pointer = const int*;
+            using reference = const int&;
+            using iterator_category = std::output_iterator_tag;
+            using iterator_assignable = my_false_type;
+
+            const_iterator():source(nullptr), i(0), k(0), value(0) {}
+
+            const_iterator operator++(int) {
+                const_iterator res = *this;
+                operator++();
+                return res;
+            }
+
+            const_iterator & operator++() {
+                if (!source || i == source->keys.size())
+                    throw invalid_iterator();
+                const Container &c = source->containers[i];
+                uint32_t low = Encode(value) & 0xffff;
+                if (!Step(c, k, low)) {
+                    if (++i == source->keys.size()) {
+                        k = value = 0;
+                        return *this;
+                    }
+                    Seek(source->containers[i], 0, k, low);
+                }
+                value = Decode(source->keys[i], low);
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator res = *this;
+                operator--();
+                return res;
+            }
+
+            const_iterator & operator--() {
+                if (!source)
+                    throw invalid_iterator();
+                uint32_t low = Encode(value) & 0xffff, k2 = k;
+                if (i == source->keys.size() || !Back(source->containers[i], k2, low)) {
+                    if (!i)
+                        throw invalid_iterator();
+                    --i;
+                    SeekBack(source->containers[i], 0xffff, k2, low);
+                }
+                k = k2;
+                value = Decode(source->keys[i], low);
+                return *this;
+            }
+
+            const int & operator*() const {
+                return value;
+            }
+
+            const int* operator->() const noexcept {
+                return &value;
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return source == rhs.source && i == rhs.i && value == rhs.value;
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return !(*this == rhs);
+            }
+        };
+        typedef const_iterator iterator;
+
+        int_set():n(0) {}
+
+        const_iterator begin() const {
+            return cbegin();
+        }
+
+        const_iterator cbegin() const {
+            if (!n)
+                return cend();
+            uint32_t k = 0, low = 0;
+            Seek(containers[0], 0, k, low);
+            return const_iterator(this, 0, k, Decode(keys[0], low));
+        }
+
+        const_iterator end() const {
+            return cend();
+        }
+
+        const_iterator cend() const {
+            return const_iterator(this, keys.size(), 0, 0);
+        }
+
+        bool empty() const {
+            return !n;
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        void clear() {
+            keys.clear();
+            containers.clear();
+            n = 0;
+        }
+
+        pair<iterator, bool> insert(const int &value) {
+            uint32_t u = Encode(value), high = u >> 16, low = u & 0xffff;
+            size_t i = FindKey(high);
+            if (i == keys.size() || keys[i] != high) {
+                keys.insert(keys.begin() + i, (uint16_t)high);
+                try {
+                    containers.insert(containers.begin() + i, Container());
+                }
+                catch (...) {
+                    keys.erase(keys.begin() + i);
+                    throw;
+                }
+            }
+            bool added = Add(containers[i], low);
+            n += added;
+            uint32_t k = 0;
+            Seek(containers[i], low, k, low);
+            return pair<iterator, bool>(iterator(this, i, k, value), added);
+        }
+
+        void erase(iterator pos) {
+            if (pos.source != this || pos.i >= keys.size())
+                throw invalid_iterator();
+            Remove(containers[pos.i], Encode(pos.value) & 0xffff);
+            --n;
+            if (!containers[pos.i].card) {
+                keys.erase(keys.begin() + pos.i);
+                containers.erase(containers.begin() + pos.i);
+            }
+        }
+
+        size_t count(const int &value) const {
+            uint32_t u = Encode(value);
+            size_t i = FindKey(u >> 16);
+            return i < keys.size() && keys[i] == u >> 16 && Contains(containers[i], u & 0xffff);
+        }
+
+        const_iterator find(const int &value) const {
+            uint32_t u = Encode(value), k = 0, low = 0;
+            size_t i = FindKey(u >> 16);
+            if (i == keys.size() || keys[i] != u >> 16 || !Seek(containers[i], u & 0xffff, k, low) || low != (u & 0xffff))
+                return cend();
+            return const_iterator(this, i, k, value);
+        }
+
+        // how many values are below value
+        size_t rank(const int &value) const {
+            uint32_t u = Encode(value);
+            size_t i = FindKey(u >> 16), res = 0;
+            for (size_t j = 0; j < i; ++j)
+                res += containers[j].card;
+            if (i < keys.size() && keys[i] == u >> 16)
+                res += Rank(containers[i], u & 0xffff);
+            return res;
+        }
+
+        // the value with rank k, counting from 0
+        int select(size_t k) const {
+            if (k >= n)
+                throw index_out_of_bound();
+            size_t i = 0;
+            for (; containers[i].card <= k; ++i)
+                k -= containers[i].card;
+            return Decode(keys[i], Select(containers[i], k));
+        }
+
+        int_set & operator|=(const int_set &other) {
+            if (this == &other)
+                return *this;
+            std::vector<uint16_t> k;
+            std::vector<Container> c;
+            k.reserve(keys.size() + other.keys.size());
+            c.reserve(keys.size() + other.keys.size());
+            size_t i = 0, j = 0;
+            n = 0;
+            while (i < keys.size() || j < other.keys.size()) {
+                if (j == other.keys.size() || (i < keys.size() && keys[i] < other.keys[j])) {
+                    k.push_back(keys[i]);
+                    c.push_back(std::move(containers[i++]));
+                }
+                else if (i == keys.size() || other.keys[j] < keys[i]) {
+                    k.push_back(other.keys[j]);
+                    c.push_back(other.containers[j++]);
+                }
+                else {
+                    k.push_back(keys[i]);
+                    c.push_back(std::move(containers[i++]));
+                    Unite(c.back(), other.containers[j++]);
+                }
+                n += c.back().card;
+            }
+            keys.swap(k);
+            containers.swap(c);
+            return *this;
+        }
+
+        int_set & operator&=(const int_set &other) {
+            if (this == &other)
+                return *this;
+            size_t i = 0, j = 0, m = 0;
+            n = 0;
+            while (i < keys.size() && j < other.keys.size()) {
+                if (keys[i] < other.keys[j])
+                    ++i;
+                else if (other.keys[j] < keys[i])
+                    ++j;
+                else {
+                    Intersect(containers[i], other.containers[j++]);
+                    if (containers[i].card) {
+                        n += containers[i].card;
+                        keys[m] = keys[i];
+                        if (m != i)
+                            containers[m] = std::move(containers[i]);
+                        ++m;
+                    }
+                    ++i;
+                }
+            }
+            keys.resize(m);
+            containers.erase(containers.begin() + m, containers.end());
+            return *this;
+        }
+
+        friend int_set operator|(int_set lhs, const int_set &rhs) {
+            return lhs |= rhs;
+        }
+
+        friend int_set operator&(int_set lhs, const int_set &rhs) {
+            return lhs &= rhs;
+        }
+
+        // moves every container to its smallest form, runs included, and
+        // trims spare capacity; worth calling once a set is built
+        void optimize() {
+            for (size_t i = 0; i < containers.size(); ++i) {
+                Container &c = containers[i];
+                size_t runs = CountRuns(c) * 4, array = c.card <= ARRAY_MAX ? c.card * 2 : (size_t)-1;
+                size_t bitmap = WORDS * 8;
+                if (runs < array && runs < bitmap) {
+                    if (c.type != RUN)
+                        ToRun(c);
+                }
+                else if (array <= bitmap) {
+                    if (c.type != ARRAY)
+                        ToArray(c);
+                }
+                else if (c.type != BITMAP)
+                    ToBitmap(c);
+                c.data.shrink_to_fit();
+            }
+            keys.shrink_to_fit();
+            containers.shrink_to_fit();
+        }
+
+        size_t memory_bytes() const {
+            size_t res = sizeof(*this) + keys.capacity() * sizeof(uint16_t) + containers.capacity() * sizeof(Container);
+            for (size_t i = 0; i < containers.size(); ++i)
+                res += containers[i].data.capacity() * sizeof(uint16_t) + containers[i].bits.capacity() * sizeof(uint64_t);
+            return res;
+        }
+    };
+}
+
+#endif
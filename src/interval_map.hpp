@@ -0,0 +1,325 @@
+#ifndef SJTU_INTERVAL_MAP_HPP
+#define SJTU_INTERVAL_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "rb_tree.hpp"
+
+namespace sjtu {
+    // a closed interval [lo, hi] and what is stored under it
+    template<class Key, class Value>
+    struct interval {
+        const Key lo, hi;
+        Value value;
+    };
+
+    // interval_map's KeyOf and Augment: the tree is ordered by lo and is
+    // also a priority search tree on hi. A node's top is the interval with
+    // the largest hi among those in its subtree that no node above holds,
+    // null when there are none; an interval no top holds is free and its
+    // own node answers for it. held marks an interval that is some top, or
+    // is loose while the tree changes
+    template<class Key, class Value>
+    struct interval_lo {
+        const Key &operator()(const interval<Key, Value> &x) const {
+            return x.lo;
+        }
+    };
+
+    template<class Key, class Compare>
+    struct interval_heap {
+        struct summary {
+            summary *top;
+            bool held;
+        };
+
+        static const bool trivial_drop = true;
+
+        Compare comp;
+
+        template<class Node>
+        static Node *Top(Node *x) {
+            return static_cast<Node *>(x->top);
+        }
+
+        template<class Node>
+        bool Lower(const Node *x, const Node *y) const {
+            return comp(x->Package()->hi, y->Package()->hi);
+        }
+
+        // the child of x whose subtree holds y, an equal lo can sit on
+        // either side so that one climbs from y
+        template<class Node>
+        Node *Toward(Node *x, Node *y) const {
+            if (comp(y->Package()->lo, x->Package()->lo))
+                return x->child[1];
+            if (comp(x->Package()->lo, y->Package()->lo))
+                return x->child[0];
+            while (y->fa != x)
+                y = y->fa;
+            return y;
+        }
+
+        // x's top is empty: the best of its children's tops and its own
+        // free interval moves up, and the slot that leaves refills in turn
+        template<class Node>
+        void Refill(Node *x) const {
+            while (true) {
+                Node *best = x->held ? nullptr : x;
+                int from = -1;
+                for (int c = 0; c < 2; ++c) {
+                    Node *t = x->child[c] ? Top(x->child[c]) : nullptr;
+                    if (t && (!best || Lower(best, t))) {
+                        best = t;
+                        from = c;
+                    }
+                }
+                x->top = best;
+                if (!best)
+                    return;
+                best->held = true;
+                if (from < 0)
+                    return;
+                x = x->child[from];
+                x->top = nullptr;
+            }
+        }
+
+        // settles the loose interval of y into x's subtree, which holds y
+        // and hangs below tops no lower than it
+        template<class Node>
+        void Sift(Node *x, Node *y) const {
+            while (true) {
+                Node *t = Top(x);
+                if (!t) {
+                    x->top = y;
+                    return;
+                }
+                if (Lower(t, y)) {
+                    x->top = y;
+                    y = t;
+                }
+                if (y == x) {
+                    y->held = false;
+                    return;
+                }
+                x = Toward(x, y);
+            }
+        }
+
+        // makes x's interval loose: the top holding it refills without it
+        template<class Node>
+        void Loosen(Node *x) const {
+            if (!x->held) {
+                x->held = true;
+                return;
+            }
+            Node *y = x;
+            while (Top(y) != x)
+                y = y->fa;
+            y->top = nullptr;
+            Refill(y);
+        }
+
+        // tops are kept from above, nothing is recomputed from the children
+        template<class Node>
+        void operator()(Node *) const {}
+
+        // x's subtree is the one y had, so x takes y's top, y refills and
+        // x's old top settles again below x
+        template<class Node>
+        void rotated(Node *x, Node *y) const {
+            Node *t = Top(x);
+            x->top = y->top;
+            y->top = nullptr;
+            Refill(y);
+            if (t)
+                Sift(x, t);
+        }
+
+        // a new node is loose until interval_map sifts it in
+        template<class Node>
+        void build(Node *x) const {
+            x->top = nullptr;
+            x->held = true;
+        }
+
+        template<class Node>
+        void drop(Node *) const {}
+
+        // tops point into the other tree, interval_map rebuilds them
+        template<class Node>
+        void copy(Node *, const Node *) const {}
+    };
+
+    // intervals ordered by lo (equal lo in insertion order) in an rb_tree
+    // whose interval_heap Augment keeps a priority search tree on hi in
+    // the same nodes. overlapping() enters a node only when its top
+    // reaches the query, and a top it does not report starts past the
+    // query, which only happens along the path toward hi; so k matches
+    // cost O(log n + k). Inserts and erases move O(log n) tops, more when
+    // many intervals share a lo
+    template<
+            class Key,
+            class Value,
+            class Compare = std::less<Key>,
+            class Allocator = std::allocator<interval<Key, Value>>
+    > class interval_map : public rb_tree<interval<Key, Value>, Key, interval_lo<Key, Value>, Compare, Allocator,
+                                          true, interval_heap<Key, Compare>> {
+        typedef rb_tree<interval<Key, Value>, Key, interval_lo<Key, Value>, Compare, Allocator,
+                        true, interval_heap<Key, Compare>> Base;
+        typedef typename Base::Node Node;
+        typedef interval_heap<Key, Compare> Augment;
+
+    public:
+        typedef interval<Key, Value> value_type;
+        typedef typename Base::iterator iterator;
+        typedef typename Base::const_iterator const_iterator;
+
+    private:
+        using Base::root;
+        using Base::comp;
+        using Base::aug;
+        using Base::MAX_DEPTH;
+
+        // every interval meeting [lo, hi], each once
+        template<class Visit>
+        void Overlapping(const Key &lo, const Key &hi, Visit visit) const {
+            Node *stack[MAX_DEPTH + 1];
+            int top = 0;
+            if (root)
+                stack[top++] = root;
+            while (top) {
+                Node *x = stack[--top], *t = Augment::Top(x);
+                if (!t || comp(t->Package()->hi, lo))
+                    continue;
+                if (!comp(hi, t->Package()->lo))
+                    visit(t);
+                if (comp(hi, x->Package()->lo)) {
+                    if (x->child[1])
+                        stack[top++] = x->child[1];
+                    continue;
+                }
+                if (!x->held && !comp(x->Package()->hi, lo))
+                    visit(x);
+                for (int c = 0; c < 2; ++c)
+                    if (x->child[c])
+                        stack[top++] = x->child[c];
+            }
+        }
+
+        // takes x's interval out of the tops and leaves the rest as
+        // rb_erase will find it: it trades places with its predecessor z
+        // when x has two children (so their tops swap first), and the top
+        // of the spot x leaves from settles into the child that moves up
+        void Remove(Node *x) {
+            aug.Loosen(x);
+            Node *z = nullptr, *at = x;
+            if (x->child[0] && x->child[1]) {
+                z = rb_extreme(x->child[1], 0);
+                aug.Loosen(z);
+                std::swap(x->top, z->top);
+                at = z;
+            }
+            Node *t = Augment::Top(x);
+            x->top = nullptr;
+            if (t)
+                aug.Sift(at->child[0] ? at->child[0] : at->child[1], t);
+            Base::Delete(x);
+            if (z)
+                aug.Sift(root, z);
+        }
+
+        // sets every top from scratch, children first: O(n)
+        void Rebuild() {
+            Node *x = root;
+            if (!x)
+                return;
+            while (true) {
+                while (x->child[0] || x->child[1])
+                    x = x->child[x->child[0] ? 0 : 1];
+                while (true) {
+                    x->held = false;
+                    x->top = nullptr;
+                    aug.Refill(x);
+                    Node *y = x->fa;
+                    if (!y)
+                        return;
+                    if (x == y->child[0] && y->child[1]) {
+                        x = y->child[1];
+                        break;
+                    }
+                    x = y;
+                }
+            }
+        }
+
+    public:
+        using Base::Base;
+
+        interval_map() = default;
+
+        interval_map(const interval_map &other):Base(other) {
+            Rebuild();
+        }
+
+        interval_map(interval_map &&other) = default;
+
+        interval_map & operator=(const interval_map &other) {
+            Base::operator=(other);
+            Rebuild();
+            return *this;
+        }
+
+        // adds [lo, hi], which may overlap or repeat intervals already there
+        iterator insert(const Key &lo, const Key &hi, const Value &value) {
+            if (comp(hi, lo))
+                throw runtime_error();
+            bool found;
+            Node *x = Base::Insert(value_type{lo, hi, value}, found);
+            aug.Sift(root, x);
+            return iterator(x, this);
+        }
+
+        void erase(const_iterator pos) {
+            Remove(Base::NodeOf(pos));
+        }
+
+        // removes every interval starting at lo, returns how many went
+        size_t erase(const Key &lo) {
+            size_t res = 0;
+            for (Node *x = Base::Find(lo); x != Base::End(); x = Base::Find(lo), ++res)
+                Remove(x);
+            return res;
+        }
+
+        // calls visit(interval) on every interval that meets [lo, hi], in
+        // no particular order, without allocating
+        template<class Visit>
+        void overlapping(const Key &lo, const Key &hi, Visit visit) {
+            Overlapping(lo, hi, [&visit](Node *x) { visit(*x->Package()); });
+        }
+
+        template<class Visit>
+        void overlapping(const Key &lo, const Key &hi, Visit visit) const {
+            Overlapping(lo, hi, [&visit](const Node *x) { visit(*x->Package()); });
+        }
+
+        // the intervals that contain point
+        template<class Visit>
+        void stabbing(const Key &point, Visit visit) {
+            overlapping(point, point, visit);
+        }
+
+        template<class Visit>
+        void stabbing(const Key &point, Visit visit) const {
+            overlapping(point, point, visit);
+        }
+    };
+}
+
+#endif
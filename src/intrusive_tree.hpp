@@ -0,0 +1,417 @@
+#ifndef SJTU_INTRUSIVE_TREE_HPP
+#define SJTU_INTRUSIVE_TREE_HPP
+
+#include <functional>
+#include <cstddef>
+#include <iterator>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "rb_core.hpp"
+
+namespace sjtu {
+    // the links a struct inherits to sit in an intrusive_tree, one base per
+    // tree it can be in at the same time, told apart by Tag
+    template<class Tag = void>
+    class rb_hook {
+    public:
+        rb_hook *child[2];
+        rb_hook *fa;
+        rb_color color;
+
+        rb_hook():fa(nullptr), color(RB_BLACK) {
+            child[0] = child[1] = nullptr;
+        }
+
+        // a copied object is not in any tree
+        rb_hook(const rb_hook &):rb_hook() {}
+
+        rb_hook & operator=(const rb_hook &) {
+            return *this;
+        }
+    };
+
+    // ordered container over objects the caller owns: T derives from
+    // rb_hook<Tag>, KeyOf reads its key, and insert/erase only relink the
+    // hooks with rb_core, so neither allocates nor copies. An object must
+    // outlive its stay in the tree and be erased before its key changes
+    template<
+            class T,
+            class Key,
+            class KeyOf,
+            class Compare = std::less<Key>,
+            class Tag = void
+    > class intrusive_tree {
+    public:
+        typedef T value_type;
+        typedef rb_hook<Tag> hook_type;
+
+    private:
+        typedef hook_type Node;
+
+        Compare comp;
+        KeyOf key_of;
+        Node *root;
+        Node verge; // end(), never a T
+        size_t n;
+
+        static T *Object(Node *x) {
+            return static_cast<T *>(x);
+        }
+
+        static const T *Object(const Node *x) {
+            return static_cast<const T *>(x);
+        }
+
+        const Key &GetKey(const Node *x) const {
+            return key_of(*Object(x));
+        }
+
+        bool Equal(const Key &a, const Key &b) const {
+            return !comp(a, b) && !comp(b, a);
+        }
+
+        Node *End() const {
+            return const_cast<Node *>(&verge);
+        }
+
+        Node *Find(const Key &key) const {
+            Node *x = root;
+            while (x) {
+                if (Equal(key, GetKey(x)))
+                    return x;
+                x = x->child[comp(key, GetKey(x))];
+            }
+            return End();
+        }
+
+        // the first node whose key is not below key (upper: above key)
+        Node *Bound(const Key &key, bool upper) const {
+            Node *x = root, *res = End();
+            while (x) {
+                if (upper ? comp(key, GetKey(x)) : !comp(GetKey(x), key)) {
+                    res = x;
+                    x = x->child[1];
+                }
+                else
+                    x = x->child[0];
+            }
+            return res;
+        }
+
+    public:
+        class const_iterator;
+        class iterator {
+        private:
+            Node *ptr;
+            const intrusive_tree *source;
+
+            friend intrusive_tree;
+
+            iterator(Node *ptr, const intrusive_tree *source):ptr(ptr), source(source) {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+            using pointer = T*;
+            using reference = T&;
+            using iterator_category = std::output_iterator_tag;
+            using iterator_assignable = my_true_type;
+
+            iterator():ptr(nullptr), source(nullptr) {}
+
+            iterator operator++(int) {
+                iterator res = *this;
+                operator++();
+                return res;
+            }
+
+            iterator & operator++() {
+                if (!source || ptr == source->End())
+                    throw invalid_iterator();
+                ptr = rb_step(ptr, 1);
+                if (!ptr)
+                    ptr = source->End();
+                return *this;
+            }
+
+            iterator operator--(int) {
+                iterator res = *this;
+                operator--();
+                return res;
+            }
+
+            iterator & operator--() {
+                if (!source)
+                    throw invalid_iterator();
+                Node *x = ptr == source->End() ? (source->root ? rb_extreme(source->root, 0) : nullptr)
+                                               : rb_step(ptr, 0);
+                if (!x)
+                    throw invalid_iterator();
+                ptr = x;
+                return *this;
+            }
+
+            T & operator*() const {
+                return *Object(ptr);
+            }
+
+            T* operator->() const noexcept {
+                return Object(ptr);
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return ptr == rhs.ptr;
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return ptr == rhs.ptr;
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return ptr != rhs.ptr;
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return ptr != rhs.ptr;
+            }
+        };
+        class const_iterator {
+        private:
+            const Node *ptr;
+            const intrusive_tree *source;
+
+            friend intrusive_tree;
+
+            const_iterator(const Node *ptr, const intrusive_tree *source):ptr(ptr), source(source) {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+            using pointer = const T*;
+            using reference = const T&;
+            using iterator_category = std::output_iterator_tag;
+            using iterator_assignable = my_false_type;
+
+            const_iterator():ptr(nullptr), source(nullptr) {}
+
+            const_iterator(const iterator &other):ptr(other.ptr), source(other.source) {}
+
+            const_iterator operator++(int) {
+                const_iterator res = *this;
+                operator++();
+                return res;
+            }
+
+            const_iterator & operator++() {
+                if (!source || ptr == source->End())
+                    throw invalid_iterator();
+                ptr = rb_step(ptr, 1);
+                if (!ptr)
+                    ptr = source->End();
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator res = *this;
+                operator--();
+                return res;
+            }
+
+            const_iterator & operator--() {
+                if (!source)
+                    throw invalid_iterator();
+                const Node *x = ptr == source->End() ? (source->root ? rb_extreme(source->root, 0) : nullptr)
+                                                     : rb_step(ptr, 0);
+                if (!x)
+                    throw invalid_iterator();
+                ptr = x;
+                return *this;
+            }
+
+            const T & operator*() const {
+                return *Object(ptr);
+            }
+
+            const T* operator->() const noexcept {
+                return Object(ptr);
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return ptr == rhs.ptr;
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return ptr == rhs.ptr;
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return ptr != rhs.ptr;
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return ptr != rhs.ptr;
+            }
+        };
+
+        explicit intrusive_tree(const KeyOf &key_of = KeyOf(), const Compare &comp = Compare()):
+                comp(comp), key_of(key_of), root(nullptr), n(0) {}
+
+        // the objects can't be in two trees through the same hook
+        intrusive_tree(const intrusive_tree &other) = delete;
+        intrusive_tree & operator=(const intrusive_tree &other) = delete;
+
+        ~intrusive_tree() {
+            clear();
+        }
+
+        iterator begin() {
+            return iterator(root ? rb_extreme(root, 1) : End(), this);
+        }
+
+        const_iterator cbegin() const {
+            return const_iterator(root ? rb_extreme(root, 1) : End(), this);
+        }
+
+        iterator end() {
+            return iterator(End(), this);
+        }
+
+        const_iterator cend() const {
+            return const_iterator(End(), this);
+        }
+
+        bool empty() const {
+            return !n;
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        // unhooks every object, the objects themselves are left alone
+        void clear() {
+            Node *stack[128];
+            int top = 0;
+            if (root)
+                stack[top++] = root;
+            while (top) {
+                Node *x = stack[--top];
+                if (x->child[0])
+                    stack[top++] = x->child[0];
+                if (x->child[1])
+                    stack[top++] = x->child[1];
+                x->child[0] = x->child[1] = x->fa = nullptr;
+            }
+            root = nullptr;
+            n = 0;
+        }
+
+        // links obj in unless an object with an equal key is there already,
+        // which is returned instead
+        pair<iterator, bool> insert(T &obj) {
+            Node *z = &obj;
+            const Key &key = key_of(obj);
+            Node *x = root, *y = nullptr;
+            bool c = false;
+            while (x) {
+                if (Equal(key, GetKey(x)))
+                    return pair<iterator, bool>(iterator(x, this), false);
+                y = x;
+                c = comp(key, GetKey(x));
+                x = x->child[c];
+            }
+            z->child[0] = z->child[1] = nullptr;
+            z->fa = y;
+            z->color = RB_RED;
+            if (y)
+                y->child[c] = z;
+            else
+                root = z;
+            rb_insert_fixup(z, root);
+            ++n;
+            return pair<iterator, bool>(iterator(z, this), true);
+        }
+
+        // links obj in after the objects with an equal key, for a tree used
+        // as a multiset; find() then returns any one of them
+        iterator insert_equal(T &obj) {
+            Node *z = &obj;
+            const Key &key = key_of(obj);
+            Node *x = root, *y = nullptr;
+            bool c = false;
+            while (x) {
+                y = x;
+                c = comp(key, GetKey(x));
+                x = x->child[c];
+            }
+            z->child[0] = z->child[1] = nullptr;
+            z->fa = y;
+            z->color = RB_RED;
+            if (y)
+                y->child[c] = z;
+            else
+                root = z;
+            rb_insert_fixup(z, root);
+            ++n;
+            return iterator(z, this);
+        }
+
+        void erase(iterator pos) {
+            if (pos.source != this || pos.ptr == End())
+                throw invalid_iterator();
+            erase(*pos);
+        }
+
+        // obj must be in this tree
+        void erase(T &obj) {
+            Node *x = &obj;
+            rb_erase(x, root);
+            x->child[0] = x->child[1] = x->fa = nullptr;
+            --n;
+        }
+
+        size_t count(const Key &key) const {
+            return Find(key) != End();
+        }
+
+        iterator find(const Key &key) {
+            return iterator(Find(key), this);
+        }
+
+        const_iterator find(const Key &key) const {
+            return const_iterator(Find(key), this);
+        }
+
+        iterator lower_bound(const Key &key) {
+            return iterator(Bound(key, false), this);
+        }
+
+        const_iterator lower_bound(const Key &key) const {
+            return const_iterator(Bound(key, false), this);
+        }
+
+        iterator upper_bound(const Key &key) {
+            return iterator(Bound(key, true), this);
+        }
+
+        const_iterator upper_bound(const Key &key) const {
+            return const_iterator(Bound(key, true), this);
+        }
+
+        // the objects with this key, [first, second)
+        pair<iterator, iterator> equal_range(const Key &key) {
+            return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+        }
+
+        pair<const_iterator, const_iterator> equal_range(const Key &key) const {
+            return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+        }
+
+        // the iterator at obj, which must be in this tree
+        iterator iterator_to(T &obj) {
+            return iterator(&obj, this);
+        }
+    };
+}
+
+#endif
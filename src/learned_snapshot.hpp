@@ -0,0 +1,160 @@
+#ifndef SJTU_LEARNED_SNAPSHOT_HPP
+#define SJTU_LEARNED_SNAPSHOT_HPP
+
+#include <functional>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "exceptions.hpp"
+#include "column_snapshot.hpp"
+
+namespace sjtu {
+    // frozen copy of an integer-keyed map with a learned index: the sorted
+    // keys are cut into segments, each a line that predicts a key's position
+    // to within error slots (PGM-style, fitted greedily with a shrinking
+    // cone), so a lookup finds its segment, evaluates the line and binary
+    // searches 2 * error + 3 slots; fits keys that are spread close to
+    // evenly, where a handful of segments covers millions of keys
+    template<class Key, class Value>
+    class learned_snapshot {
+        static_assert(std::is_integral<Key>::value, "learned_snapshot needs integer keys");
+
+    private:
+        struct Segment {
+            Key key;
+            double slope;
+            size_t start;
+        };
+
+        column_snapshot<Key, Value> sorted;
+        std::vector<Segment> segments;
+        size_t error;
+
+        // key - base as a double, keys may span the whole integer range
+        static double Offset(Key key, Key base) {
+            typedef typename std::make_unsigned<Key>::type Unsigned;
+            return (double)(Unsigned)((Unsigned)key - (Unsigned)base);
+        }
+
+        void Fit() {
+            size_t n = sorted.size();
+            const Key *k = sorted.keys();
+            double e = (double)error;
+            for (size_t i = 0; i < n; ) {
+                size_t start = i;
+                double lo = 0, hi = 1e300;
+                for (++i; i < n; ++i) {
+                    double dx = Offset(k[i], k[start]), dy = (double)(i - start);
+                    double a = (dy - e) / dx, b = (dy + e) / dx;
+                    if (a > hi || b < lo)
+                        break;
+                    lo = a > lo ? a : lo;
+                    hi = b < hi ? b : hi;
+                }
+                double slope = i - start == 1 ? 0 : (lo + hi) / 2;
+                segments.push_back(Segment{k[start], slope, start});
+            }
+        }
+
+        // same branch-free search as column_snapshot, over [lo, hi)
+        static size_t Search(const Key *k, size_t lo, size_t hi, Key key) {
+            if (lo >= hi)
+                return lo;
+            const Key *base = k + lo;
+            size_t len = hi - lo;
+            while (len > 1) {
+                size_t half = len / 2;
+                base = base[half] < key ? base + half : base;
+                len -= half;
+            }
+            return (base - k) + (*base < key);
+        }
+
+        size_t LowerBound(Key key) const {
+            size_t n = sorted.size();
+            const Key *k = sorted.keys();
+            if (!n || key <= k[0])
+                return 0;
+            // last segment starting at or below key
+            size_t s = 0, len = segments.size();
+            while (len > 1) {
+                size_t half = len / 2;
+                s = segments[s + half].key <= key ? s + half : s;
+                len -= half;
+            }
+            const Segment &g = segments[s];
+            double guess = (double)g.start + g.slope * Offset(key, g.key);
+            size_t pos = guess <= 0 ? 0 : guess >= (double)n ? n : (size_t)guess;
+            size_t lo = pos > error + 1 ? pos - error - 1 : 0;
+            size_t hi = pos + error + 2 < n ? pos + error + 2 : n;
+            size_t x = Search(k, lo, hi, key);
+            // rounding can only bite at the window's edges, fall back there
+            if ((x == lo && lo && !(k[lo - 1] < key)) || (x == hi && hi < n && k[hi] < key))
+                x = Search(k, 0, n, key);
+            return x;
+        }
+
+        size_t Find(Key key) const {
+            size_t x = LowerBound(key);
+            return x < sorted.size() && sorted.keys()[x] == key ? x : sorted.size();
+        }
+
+    public:
+        learned_snapshot():error(0) {}
+
+        // error bounds how far a prediction may miss, in slots
+        explicit learned_snapshot(column_snapshot<Key, Value> sorted, size_t error = 32):
+                sorted(std::move(sorted)), error(error) {
+            Fit();
+        }
+
+        size_t size() const {
+            return sorted.size();
+        }
+
+        bool empty() const {
+            return sorted.empty();
+        }
+
+        const Key *keys() const {
+            return sorted.keys();
+        }
+
+        const Value *values() const {
+            return sorted.values();
+        }
+
+        size_t lower_bound(Key key) const {
+            return LowerBound(key);
+        }
+
+        size_t count(Key key) const {
+            return Find(key) != sorted.size();
+        }
+
+        // nullptr when key is absent
+        const Value *find(Key key) const {
+            size_t x = Find(key);
+            return x != sorted.size() ? sorted.values() + x : nullptr;
+        }
+
+        const Value & at(Key key) const {
+            size_t x = Find(key);
+            if (x == sorted.size())
+                throw index_out_of_bound();
+            return sorted.values()[x];
+        }
+
+        size_t segment_count() const {
+            return segments.size();
+        }
+
+        // the model alone, the key and value columns not counted
+        size_t index_bytes() const {
+            return segments.size() * sizeof(Segment);
+        }
+    };
+}
+
+#endif
@@ -4,328 +4,866 @@
 // only for std::less<T>
 #include <functional>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 #include "utility.hpp"
 #include "exceptions.hpp"
+#include "column_snapshot.hpp"
+#include "hash_snapshot.hpp"
+#include "learned_snapshot.hpp"
+#include "bloom_filter.hpp"
+#include "node_pool.hpp"
+#include "rb_core.hpp"
 
 namespace sjtu {
-    struct my_true_type {};
-    struct my_false_type {};
-
     template<class T>
     struct my_type_traits {
         using iterator_assignable = typename T::iterator_assignable;
     };
 
+    // map keeps each value next to its key by default; specialize this
+    // with split_values = my_true_type for big values, then nodes hold
+    // only a key and links and the pair sits in a separate cold arena that
+    // a lookup touches only on a hit
+    template<class Key, class Value>
+    struct my_layout_traits {
+        using split_values = my_false_type;
+    };
+
+    // specialize with enabled = my_true_type and a static
+    // uint64_t prefix(const Key &) for keys that are costly to compare,
+    // such as big integers or long strings: map then caches the prefix in
+    // every node and compares the full keys only where the prefixes tie.
+    // prefix must keep the order of Compare, comp(a, b) implies
+    // prefix(a) <= prefix(b)
+    template<class Key, class Compare>
+    struct key_normalizer {
+        using enabled = my_false_type;
+    };
+
+    // the first eight bytes, big-endian and zero padded
+    template<>
+    struct key_normalizer<std::string, std::less<std::string>> {
+        using enabled = my_true_type;
+
+        static uint64_t prefix(const std::string &key) {
+            uint64_t res = 0;
+            size_t len = key.size() < 8 ? key.size() : 8;
+            for (size_t i = 0; i < len; ++i)
+                res |= (uint64_t)(unsigned char)key[i] << (56 - 8 * i);
+            return res;
+        }
+    };
+
+    // node orders map::compact can lay a tree out in
+    enum map_layout {IN_ORDER_LAYOUT, DFS_LAYOUT, VEB_LAYOUT};
+
+    template<class Key, class Value, class Split>
+    class map_node_data {
+    public:
+        typedef pair<const Key, Value> value_type;
+
+        alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+        value_type *Package() {
+            return reinterpret_cast<value_type *>(storage);
+        }
+
+        const value_type *Package() const {
+            return reinterpret_cast<const value_type *>(storage);
+        }
+
+        const Key &GetKey() const {
+            return Package()->first;
+        }
+    };
+
+    template<class Key, class Value>
+    class map_node_data<Key, Value, my_true_type> {
+    public:
+        typedef pair<const Key, Value> value_type;
+
+        alignas(Key) unsigned char key_storage[sizeof(Key)];
+        value_type *package;
+
+        value_type *Package() {
+            return package;
+        }
+
+        const value_type *Package() const {
+            return package;
+        }
+
+        const Key &GetKey() const {
+            return *reinterpret_cast<const Key *>(key_storage);
+        }
+    };
+
+    // the prefix a node caches with key_normalizer, nothing without
+    template<class Enabled>
+    class map_node_prefix {
+    public:
+        void SetPrefix(uint64_t) {}
+
+        void CopyPrefix(const map_node_prefix &) {}
+
+        // undecided, the keys have to be compared
+        int ComparePrefix(uint64_t) const {
+            return 0;
+        }
+    };
+
+    template<>
+    class map_node_prefix<my_true_type> {
+    public:
+        uint64_t prefix;
+
+        void SetPrefix(uint64_t p) {
+            prefix = p;
+        }
+
+        void CopyPrefix(const map_node_prefix &other) {
+            prefix = other.prefix;
+        }
+
+        // the sign of p - prefix, 0 when they tie
+        int ComparePrefix(uint64_t p) const {
+            return p < prefix ? -1 : p > prefix;
+        }
+    };
+
     template<
             class Key,
             class Value,
-            class Compare = std::less<Key>
+            class Compare = std::less<Key>,
+            class Allocator = std::allocator<pair<const Key, Value>>
     > class map {
     public:
         typedef pair<const Key, Value> value_type;
+        typedef Allocator allocator_type;
 
     private:
         Compare comp;
-        enum Color {RED, BLACK};
-
-        class Node {
+        typedef rb_color Color;
+        static const Color RED = RB_RED, BLACK = RB_BLACK;
+        using split_values = typename my_layout_traits<Key, Value>::split_values;
+        typedef key_normalizer<Key, Compare> Normalizer;
+        using normalized = typename Normalizer::enabled;
+
+        // the package is constructed by the map, verge leaves it raw
+        class Node : public map_node_data<Key, Value, split_values>, public map_node_prefix<normalized> {
         public:
-            value_type *package;
-            Color color;
             Node *child[2];
             Node *fa;
+            Color color;
+        };
 
-            Node() {
-                package = nullptr;
-                fa = child[0] = child[1] = nullptr;
-            }
-
-            Node(Key key, Value value, Color color = RED):color(color) {
-                package = new value_type(key, value);
-                fa = child[0] = child[1] = nullptr;
-            }
+        // a cold arena slot, wide enough for the free-list link
+        union ColdSlot {
+            alignas(value_type) unsigned char storage[sizeof(value_type)];
+            ColdSlot *next;
+        };
 
-            Node(const Node &obj) {
-                package = new value_type(*obj.package);
-                color = obj.color;
-                fa = child[0] = child[1] = nullptr;
+        typedef node_pool<Node, Allocator> Pool;
+        typedef node_pool<ColdSlot, Allocator> ColdPool;
+        typedef typename Pool::allocator_type NodeAllocator;
+        typedef typename ColdPool::allocator_type ColdAllocator;
+        typedef std::allocator_traits<NodeAllocator> NodeTraits;
+        using trivially_copyable = typename std::conditional<
+                std::is_trivially_copyable<value_type>::value, my_true_type, my_false_type>::type;
+        static const bool SPLIT = std::is_same<split_values, my_true_type>::value;
+        // teardown may skip the node walk and just drop the pools
+        static const bool TRIVIAL_TEARDOWN = std::is_trivially_destructible<value_type>::value
+                && (!SPLIT || std::is_trivially_destructible<Key>::value);
+
+        // copies above this size split the tree across threads
+        static const size_t PARALLEL_COPY = 1 << 20;
+        static const int PARALLEL_WIDTH = 8;
+
+        // a tree cut off the map by clear_deferred/clear_async, it is torn
+        // down by rotating child[1] up so no stack is needed and the
+        // work can stop and resume at any node
+        struct Graveyard {
+            Pool pool;
+            ColdPool cold;
+            Node *rest;
+            Graveyard *next;
+
+            Graveyard(const NodeAllocator &alloc):pool(alloc), cold(ColdAllocator(alloc)),
+                    rest(nullptr), next(nullptr) {}
+
+            // spends at most budget steps, returns what is left of it
+            size_t Reclaim(size_t budget) {
+                for (; budget && rest; --budget) {
+                    Node *x = rest, *y = x->child[1];
+                    if (y) {
+                        x->child[1] = y->child[0];
+                        y->child[0] = x;
+                        rest = y;
+                    }
+                    else {
+                        rest = x->child[0];
+                        DropPackage(x, split_values());
+                    }
+                }
+                return cold.release(pool.release(budget));
             }
 
-            bool ChildNumber(const Node * const &obj) const {
-                return obj == child[1];
+            bool Done() const {
+                return !rest && pool.empty() && cold.empty();
             }
+        };
 
-            ~Node() {
-                if (package)
-                    delete package;
-            }
+        // a relayout in progress: nodes move one at a time into the single
+        // block of fresh in the order tasks yields them, and the tree stays
+        // valid between slices
+        struct Compaction {
+            struct Task {
+                Node *x;
+                int h; // in-order: expanded or not, vEB: height of the piece
+            };
+
+            Pool fresh;
+            Node *mem;
+            size_t next, size; // slots of mem filled and in all
+            map_layout order;
+            std::vector<Task> tasks;
+
+            Compaction(const NodeAllocator &alloc, map_layout order):fresh(alloc), mem(nullptr),
+                    next(0), size(0), order(order) {}
         };
 
+        Pool pool;
+        ColdPool cold;
+        Graveyard *graveyard;
+        Compaction *compaction;
+
         Node *root, *verge;
-        int n;
+        size_t n;
+
+        // optional, in front of Find; it may still hold erased keys
+        bloom_filter<Key> *bloom;
+        static const size_t BLOOM_MIN = 64;
 
         bool Equal(const Key &a, const Key &b) const {
             return !comp(a, b) && !comp(b, a);
         }
 
-        void Construct(Node *&x, Node *y) {
-            if (!y)
-                return;
-            x = new Node(*y);
-            ++n;
-            Construct(x->child[0], y->child[0]);
-            Construct(x->child[1], y->child[1]);
-            if (x->child[0])
-                x->child[0]->fa = x;
-            if (x->child[1])
-                x->child[1]->fa = x;
+        static uint64_t Normalize(const Key &key, my_true_type) {
+            return Normalizer::prefix(key);
         }
 
-        void Destruct(Node *&x) {
-            if (!x)
+        static uint64_t Normalize(const Key &, my_false_type) {
+            return 0;
+        }
+
+        // where key goes from x: -1 when x holds it, else the child; the
+        // cached prefix settles most steps without reading x's key
+        int Side(const Key &key, uint64_t p, const Node *x) const {
+            int c = x->ComparePrefix(p);
+            if (c)
+                return c < 0;
+            if (Equal(key, x->GetKey()))
+                return -1;
+            return comp(key, x->GetKey());
+        }
+
+        Node *AllocateNode() {
+            return new (pool.allocate(n)) Node;
+        }
+
+        void BuildPackage(Node *x, const Key &key, const Value &value, my_false_type) {
+            new (x->storage) value_type(key, value);
+        }
+
+        void BuildPackage(Node *x, const Key &key, const Value &value, my_true_type) {
+            ColdSlot *slot = cold.allocate(n);
+            value_type *p = reinterpret_cast<value_type *>(slot->storage);
+            try {
+                new (p) value_type(key, value);
+                try {
+                    new (x->key_storage) Key(key);
+                }
+                catch (...) {
+                    p->~value_type();
+                    throw;
+                }
+            }
+            catch (...) {
+                cold.deallocate(slot);
+                throw;
+            }
+            x->package = p;
+        }
+
+        // destroys what the node holds, cold slots are left to the caller
+        static void DropPackage(Node *x, my_false_type) {
+            x->Package()->~value_type();
+        }
+
+        static void DropPackage(Node *x, my_true_type) {
+            x->package->~value_type();
+            reinterpret_cast<Key *>(x->key_storage)->~Key();
+        }
+
+        void ReturnCold(Node *, my_false_type) {}
+
+        void ReturnCold(Node *x, my_true_type) {
+            cold.deallocate(reinterpret_cast<ColdSlot *>(x->package));
+        }
+
+        Node *NewNode(const Key &key, const Value &value, Color color = RED) {
+            Node *x = AllocateNode();
+            try {
+                BuildPackage(x, key, value, split_values());
+            }
+            catch (...) {
+                pool.deallocate(x);
+                throw;
+            }
+            x->SetPrefix(Normalize(key, normalized()));
+            x->color = color;
+            x->fa = x->child[0] = x->child[1] = nullptr;
+            return x;
+        }
+
+        void DeleteNode(Node *x) {
+            DropPackage(x, split_values());
+            ReturnCold(x, split_values());
+            pool.deallocate(x);
+        }
+
+        Node *NewVerge() {
+            NodeAllocator alloc = pool.get_allocator();
+            Node *x = new (NodeTraits::allocate(alloc, 1)) Node;
+            x->fa = x->child[0] = x->child[1] = nullptr;
+            return x;
+        }
+
+        void Initialize() {
+            graveyard = nullptr;
+            compaction = nullptr;
+            root = nullptr;
+            n = 0;
+            bloom = nullptr;
+            verge = NewVerge();
+        }
+
+        static void CopyPackage(Node *x, const Node *y, my_true_type) {
+            std::memcpy(x->storage, y->storage, sizeof(value_type));
+        }
+
+        static void CopyPackage(Node *x, const Node *y, my_false_type) {
+            new (x->storage) value_type(*y->Package());
+        }
+
+        void ClonePackage(Node *x, const Node *y, my_false_type) {
+            CopyPackage(x, y, trivially_copyable());
+        }
+
+        void ClonePackage(Node *x, const Node *y, my_true_type) {
+            BuildPackage(x, y->GetKey(), y->Package()->second, my_true_type());
+        }
+
+        // touches the cold arena only with split values, which never copy
+        // in parallel
+        Node *CloneNode(const Node *y, Node *x) {
+            new (x) Node;
+            ClonePackage(x, y, split_values());
+            x->CopyPrefix(*y);
+            x->color = y->color;
+            x->child[0] = x->child[1] = nullptr;
+            return x;
+        }
+
+        static size_t Count(const Node *x) {
+            const Node *stack[MAX_DEPTH + 1];
+            int top = 0;
+            size_t res = 0;
+            if (x)
+                stack[top++] = x;
+            while (top) {
+                x = stack[--top];
+                ++res;
+                if (x->child[0])
+                    stack[top++] = x->child[0];
+                if (x->child[1])
+                    stack[top++] = x->child[1];
+            }
+            return res;
+        }
+
+        // preorder copy of subtree y into consecutive slots from mem, every
+        // node is linked as soon as its package is built so a throwing copy
+        // still leaves a well-formed tree behind
+        size_t CopyTree(const Node *y, Node *fa, Node *&x, Node *mem) {
+            const Node *src[MAX_DEPTH + 1];
+            Node *dst[MAX_DEPTH + 1];
+            int top = 0;
+            size_t k = 0;
+            x = CloneNode(y, mem + k++);
+            x->fa = fa;
+            src[top] = y;
+            dst[top++] = x;
+            while (top) {
+                --top;
+                const Node *s = src[top];
+                Node *d = dst[top];
+                for (int c = 0; c < 2; ++c)
+                    if (s->child[c]) {
+                        Node *e = CloneNode(s->child[c], mem + k++);
+                        e->fa = d;
+                        d->child[c] = e;
+                        src[top] = s->child[c];
+                        dst[top++] = e;
+                    }
+            }
+            return k;
+        }
+
+        // the top of the tree is copied here, the subtrees hanging below it
+        // are sized and then copied on their own threads into disjoint
+        // slices of mem
+        void ParallelCopy(const Node *y, Node *mem) {
+            struct Task {
+                const Node *src;
+                Node *fa;
+                int c;
+                size_t size;
+            } task[PARALLEL_WIDTH * 2];
+            int head = 0, tail = 0;
+            size_t k = 0;
+            root = CloneNode(y, mem + k++);
+            root->fa = nullptr;
+            for (int c = 0; c < 2; ++c)
+                if (y->child[c])
+                    task[tail++] = Task{y->child[c], root, c, 0};
+            while (head < tail && tail - head < PARALLEL_WIDTH) {
+                Task t = task[head++];
+                Node *x = CloneNode(t.src, mem + k++);
+                x->fa = t.fa;
+                t.fa->child[t.c] = x;
+                for (int c = 0; c < 2; ++c)
+                    if (t.src->child[c])
+                        task[tail++] = Task{t.src->child[c], x, c, 0};
+            }
+            // a thread that can't be started (out of threads or memory)
+            // leaves its task and the ones after it to this thread
+            std::thread worker[PARALLEL_WIDTH];
+            int started = head;
+            try {
+                for (; started < tail; ++started)
+                    worker[started - head] = std::thread([&task, started]() {
+                        task[started].size = Count(task[started].src);
+                    });
+            }
+            catch (...) {}
+            for (int i = head; i < started; ++i)
+                worker[i - head].join();
+            for (int i = started; i < tail; ++i)
+                task[i].size = Count(task[i].src);
+            Node *slice[PARALLEL_WIDTH];
+            for (int i = head; i < tail; ++i) {
+                slice[i - head] = mem + k;
+                k += task[i].size;
+            }
+            started = head;
+            try {
+                for (; started < tail; ++started)
+                    worker[started - head] = std::thread([this, &task, &slice, head, started]() {
+                        Task &t = task[started];
+                        CopyTree(t.src, t.fa, t.fa->child[t.c], slice[started - head]);
+                    });
+            }
+            catch (...) {}
+            for (int i = head; i < started; ++i)
+                worker[i - head].join();
+            for (int i = started; i < tail; ++i)
+                CopyTree(task[i].src, task[i].fa, task[i].fa->child[task[i].c], slice[i - head]);
+        }
+
+        // the whole copy lands in one block sized to other
+        void Copy(const map &other) {
+            root = nullptr;
+            n = 0;
+            CopyBloom(other);
+            if (!other.root)
                 return;
-            Destruct(x->child[0]);
-            Destruct(x->child[1]);
-            delete x;
-            x = nullptr;
+            Node *mem = pool.allocate_block(other.n);
+            try {
+                if (other.n >= PARALLEL_COPY && std::thread::hardware_concurrency() > 1
+                        && std::is_nothrow_copy_constructible<value_type>::value && !SPLIT)
+                    ParallelCopy(other.root, mem);
+                else
+                    CopyTree(other.root, nullptr, root, mem);
+            }
+            catch (...) {
+                Destruct();
+                throw;
+            }
+            n = other.n;
+        }
+
+        // hands the tree and its blocks over in O(1), the map is left empty
+        Graveyard *Detach() {
+            AbortCompaction();
+            Graveyard *g = new Graveyard(pool.get_allocator());
+            g->pool.swap(pool);
+            g->cold.swap(cold);
+            if (!TRIVIAL_TEARDOWN)
+                g->rest = root;
+            root = nullptr;
+            n = 0;
+            if (bloom)
+                bloom->clear();
+            return g;
+        }
+
+        void Destruct() {
+            if (!TRIVIAL_TEARDOWN)
+                Traverse(1, [](Node *x) { DropPackage(x, split_values()); });
+            delete compaction;
+            compaction = nullptr;
+            pool.release();
+            cold.release();
+            root = nullptr;
+            n = 0;
+            if (bloom)
+                bloom->clear();
         }
 
         Node *Insert(const Key &key, bool &flag) {
             Node *x = root, *y = nullptr;
+            uint64_t p = Normalize(key, normalized());
+            int c = 0;
             while (true) {
                 if (!x) {
-                    x = new Node(key, Value());
+                    // ending a relayout may move y, so the descent starts over
+                    if (compaction) {
+                        AbortCompaction();
+                        return Insert(key, flag);
+                    }
+                    x = NewNode(key, Value());
                     ++n;
                     x->fa = y;
-                    y->child[comp(key, y->package->first)] = x;
+                    y->child[c] = x;
                     flag = false;
                     return x;
                 }
-                if (Equal(key, x->package->first)) {
+                c = Side(key, p, x);
+                if (c < 0) {
                     flag = true;
                     return x;
                 }
                 y = x;
-                x = x->child[comp(key, x->package->first)];
+                x = x->child[c];
             }
         }
 
-        bool CheckColor(Node *x, Color color) {
-            if (!x)
-                return color == BLACK;
-            return x->color == color;
-        }
-
-        void SetColor(Node *x, Color color) {
-            if (!x)
-                return;
-            x->color = color;
-        }
-
         void Debug(Node *x) {
-            if (!x)
-                return;
-            int a = !x->child[0] ? -1 : x->child[0]->package->first;
-            int b = !x->child[1] ? -1 : x->child[1]->package->first;
-            printf("%d(%d): %d %d\n", x->package->first, x->color, a, b);
-            Debug(x->child[0]);
-            Debug(x->child[1]);
-        }
-
-        void Rotate(Node *x) {
-            Node *y = x->fa, *w = y->fa;
-            bool c = y->ChildNumber(x);
-            Node *z = x->child[!c];
-            x->child[!c] = y;
-            y->child[c] = z;
-            x->fa = w;
-            y->fa = x;
-            if (z)
-                z->fa = y;
-            if (w)
-                w->child[w->ChildNumber(y)] = x;
-            if (!x->fa)
-                root = x;
+            Node *stack[MAX_DEPTH + 1];
+            int top = 0;
+            if (x)
+                stack[top++] = x;
+            while (top) {
+                x = stack[--top];
+                int a = !x->child[0] ? -1 : x->child[0]->Package()->first;
+                int b = !x->child[1] ? -1 : x->child[1]->Package()->first;
+                printf("%d(%d): %d %d\n", x->Package()->first, x->color, a, b);
+                if (x->child[1])
+                    stack[top++] = x->child[1];
+                if (x->child[0])
+                    stack[top++] = x->child[0];
+            }
         }
 
         Node *Insert(const Key &key) {
             if (!root) {
-                root = new Node(key, Value(), BLACK);
+                root = NewNode(key, Value(), BLACK);
                 ++n;
+                if (bloom)
+                    BloomInsert(key);
                 return root;
             }
             bool flag;
-            Node *x = Insert(key, flag), *res = x;
-            if (flag)
-                return res;
-            while (true) {
-                Node *y = x->fa; // y can't be nullptr
-                if (y->color == BLACK)
-                    break;
-                Node *z = y->fa; // z can't be nullptr
-                bool c = z->ChildNumber(y);
-                if (CheckColor(z->child[!c], RED)) { // situation 1
-                    z->color = RED;
-                    y->color = BLACK;
-                    SetColor(z->child[!c], BLACK);
-                    if (z == root) {
-                        z->color = BLACK;
-                        break;
-                    }
-                    x = z;
-                }
-                else if (z->ChildNumber(y) == y->ChildNumber(x)){ // situation 2
-                    Rotate(y);
-                    y->color = BLACK;
-                    SetColor(y->child[!c], RED);
-                    break;
-                }
-                else {
-                    Rotate(x);
-                    Rotate(x);
-                    x->color = BLACK;
-                    z->color = RED;
-                    break;
-                }
+            Node *x = Insert(key, flag);
+            if (!flag) {
+                rb_insert_fixup(x, root);
+                if (bloom)
+                    BloomInsert(key);
             }
-            return res;
+            return x;
         }
 
+        // a key the filter rules out is not in the tree
         Node *Find(const Key &key) const {
+            if (bloom && !bloom->might_contain(key))
+                return verge;
             Node *x = root;
+            uint64_t p = Normalize(key, normalized());
             while (true) {
                 if (!x)
                     return verge;
-                if (Equal(key, x->package->first))
+                int c = Side(key, p, x);
+                if (c < 0)
                     return x;
-                x = x->child[comp(key, x->package->first)];
+                x = x->child[c];
             }
         }
 
-        Node *Minimum(Node *x) {
-            while (x->child[0])
-                x = x->child[0];
-            return x;
+        void Delete(Node *x) {
+            x = AbortCompaction(x);
+            --n;
+            rb_erase(x, root);
+            DeleteNode(x);
+            // erased keys stay in the filter until they are half of it
+            if (bloom && bloom->size() > 2 * n + BLOOM_MIN)
+                RebuildBloom();
         }
 
-        void Transplant(Node *x, Node *y) {
-            if (!x->fa)
-                root = y;
-            else {
-                Node *z = x->fa;
-                z->child[z->ChildNumber(x)] = y;
-                y->fa = z;
+        // builds a filter sized for twice the keys there are now beside the
+        // old one and swaps it in; if that throws the map drops its filter,
+        // as one missing live keys would hide them from Find
+        void RebuildBloom() {
+            bloom_filter<Key> *f = nullptr;
+            try {
+                f = new bloom_filter<Key>(*bloom, 2 * n + BLOOM_MIN);
+                Traverse(1, [f](Node *x) { f->insert(x->GetKey()); });
+            }
+            catch (...) {
+                delete f;
+                f = nullptr;
             }
+            delete bloom;
+            bloom = f;
         }
 
-        void DeleteFixUp(Node *x) {
-            Node *y = x->fa, *z = y->child[!y->ChildNumber(x)];
-            int c = y->ChildNumber(x);
-            while (true) {
-                if (x->color == RED) {
-                    x->color = BLACK;
-                    break;
-                }
-                if (x == root)
-                    break;
-                if (CheckColor(z, RED)) {
-                    z->color = BLACK;
-                    y->color = RED;
-                    Rotate(z);
-                    y = x->fa, c = y->ChildNumber(x), z = y->child[!c];
-                }
-                if (CheckColor(z->child[0], BLACK) && CheckColor(z->child[1], BLACK)) {
-                    z->color = RED;
-                    x = y, y = x->fa;
-                    if (y)
-                        c = y->ChildNumber(x), z = y->child[!c];
-                    continue;
-                }
-                if (CheckColor(z->child[c], RED) && CheckColor(z->child[!c], BLACK)) {
-                    z->child[c]->color = BLACK;
-                    z->color = RED;
-                    Rotate(z->child[c]);
-                    y = x->fa, c = y->ChildNumber(x), z = y->child[!c];
-                }
-                if (CheckColor(z->child[!c], RED)) {
-                    z->color = y->color;
-                    y->color = BLACK;
-                    z->child[!c]->color = BLACK;
-                    Rotate(z);
-                    break;
-                }
+        // key is already linked, so a throwing hash drops the filter too
+        void BloomInsert(const Key &key) {
+            try {
+                bloom->insert(key);
             }
+            catch (...) {
+                disable_bloom_filter();
+                return;
+            }
+            if (bloom->size() > bloom->capacity())
+                RebuildBloom();
         }
 
-        void SetFa(Node *x, Node *y) {
-            if (x)
-                x->fa = y;
+        void CopyBloom(const map &other) {
+            if (!other.bloom) {
+                delete bloom;
+                bloom = nullptr;
+            }
+            else if (bloom)
+                *bloom = *other.bloom;
+            else
+                bloom = new bloom_filter<Key>(*other.bloom);
         }
 
-        void ReplaceChild(Node *x, Node *y, Node *z) {
-            if (x)
-                x->child[x->ChildNumber(y)] = z;
+        // the height of a red-black tree is at most 2 * log2(n + 1)
+        static const int MAX_DEPTH = 128;
+
+        static void Prefetch(const void *p) {
+#if defined(__GNUC__)
+            __builtin_prefetch(p);
+#endif
         }
 
-        void Delete(Node *x) {
-            Node *y, *t;
-            Color removed;
-            bool flag = false; // delay removing it from tree
-            --n;
-            if (x == root && !x->child[0] && !x->child[1]) {
-                root = nullptr;
-                delete x;
-                return;
+        // in-order walk with an explicit stack instead of climbing fa,
+        // c is the side visited first (1 for ascending order)
+        template<class Visit>
+        void Traverse(bool c, Visit visit) const {
+            Node *stack[MAX_DEPTH];
+            int top = 0;
+            for (Node *x = root; x; x = x->child[c])
+                stack[top++] = x;
+            while (top) {
+                Node *x = stack[--top], *y = x->child[!c];
+                if (y)
+                    Prefetch(y);
+                visit(x);
+                for (; y; y = y->child[c])
+                    stack[top++] = y;
             }
-            if (!x->child[0] && !x->child[1]) {
-                removed = x->color;
-                t = y = x;
-                flag = true;
-            }
-            else if (!x->child[0] || !x->child[1]) {
-                removed = x->color;
-                y = x->child[(x->child[1] != nullptr)];
-                Transplant(t = x, y);
-            }
-            else {
-                Node *z = Minimum(x->child[1]);
-                std::swap(x->color, z->color);
-                SetFa(x->child[0], z);
-                SetFa(z->child[1], x);
-                if (z->fa == x) {
-                    z->fa = x->fa;
-                    x->fa = z;
-                    std::swap(x->child, z->child);
-                    z->child[1] = x;
-                    ReplaceChild(z->fa, x, z);
-                }
+        }
+
+        // ascending walk over keys in [lo, hi)
+        template<class Visit>
+        void Traverse(const Key &lo, const Key &hi, Visit visit) const {
+            Node *stack[MAX_DEPTH];
+            int top = 0;
+            for (Node *x = root; x; ) {
+                if (comp(x->GetKey(), lo))
+                    x = x->child[0];
                 else {
-                    SetFa(x->child[1], z);
-                    ReplaceChild(x->fa, x, z);
-                    ReplaceChild(z->fa, z, x);
-                    std::swap(x->child, z->child);
-                    std::swap(x->fa, z->fa);
+                    stack[top++] = x;
+                    x = x->child[1];
                 }
-                if (!z->fa)
-                    root = z;
-                removed = x->color;
-                if (!x->child[1]) {
-                    t = y = x;
-                    flag = true;
+            }
+            while (top) {
+                Node *x = stack[--top], *y = x->child[0];
+                if (!comp(x->GetKey(), hi))
+                    break;
+                if (y)
+                    Prefetch(y);
+                visit(x);
+                for (; y; y = y->child[1])
+                    stack[top++] = y;
+            }
+        }
+
+        static void MovePackage(Node *dst, Node *x, my_false_type) {
+            new (dst->storage) value_type(std::move_if_noexcept(*x->Package()));
+            x->Package()->~value_type();
+        }
+
+        // the cold half stays where it is
+        static void MovePackage(Node *dst, Node *x, my_true_type) {
+            Key &key = *reinterpret_cast<Key *>(x->key_storage);
+            new (dst->key_storage) Key(std::move_if_noexcept(key));
+            key.~Key();
+            dst->package = x->package;
+        }
+
+        // moves x into dst and rewires its neighbours, x's slot is left to
+        // the caller
+        void Relocate(Node *x, Node *dst) {
+            new (dst) Node;
+            MovePackage(dst, x, split_values());
+            dst->CopyPrefix(*x);
+            dst->color = x->color;
+            dst->fa = x->fa;
+            dst->child[0] = x->child[0];
+            dst->child[1] = x->child[1];
+            if (!x->fa)
+                root = dst;
+            else
+                x->fa->child[rb_child_number(x->fa, x)] = dst;
+            rb_set_fa(dst->child[0], dst);
+            rb_set_fa(dst->child[1], dst);
+        }
+
+        // splits the vEB piece at tasks[i] into its top half and the
+        // subtrees hanging below it, top first; returns the nodes visited
+        size_t ExpandPiece(size_t i) {
+            typedef typename Compaction::Task Task;
+            std::vector<Task> &tasks = compaction->tasks;
+            Node *x = tasks[i].x;
+            int h = tasks[i].h, top = h / 2;
+            Task stack[MAX_DEPTH + 1];
+            int k = 0;
+            size_t visited = 0;
+            stack[k++] = Task{x, 0};
+            try {
+                // larger side first, so the smallest bottom ends up on top
+                while (k) {
+                    Task t = stack[--k];
+                    ++visited;
+                    if (t.h == top) {
+                        tasks.push_back(Task{t.x, h - top});
+                        continue;
+                    }
+                    if (t.x->child[1])
+                        stack[k++] = Task{t.x->child[1], t.h + 1};
+                    if (t.x->child[0])
+                        stack[k++] = Task{t.x->child[0], t.h + 1};
                 }
-                else {
-                    y = x->child[1];
-                    Transplant(t = x, y);
+                tasks.push_back(Task{x, top});
+            }
+            catch (...) {
+                tasks.resize(i + 1);
+                throw;
+            }
+            tasks.erase(tasks.begin() + i);
+            return visited;
+        }
+
+        // one unit of relayout work, returns its cost
+        size_t CompactStep() {
+            typedef typename Compaction::Task Task;
+            std::vector<Task> &tasks = compaction->tasks;
+            Task t = tasks.back();
+            if (compaction->order == DFS_LAYOUT) {
+                Node *dst = compaction->mem + compaction->next;
+                tasks.reserve(tasks.size() + 1);
+                Relocate(t.x, dst);
+                pool.deallocate(t.x);
+                ++compaction->next;
+                tasks.pop_back();
+                if (dst->child[0])
+                    tasks.push_back(Task{dst->child[0], 0});
+                if (dst->child[1])
+                    tasks.push_back(Task{dst->child[1], 0});
+                return 1;
+            }
+            if (compaction->order == IN_ORDER_LAYOUT && !t.h) {
+                tasks.reserve(tasks.size() + 2);
+                Node *x = t.x;
+                // larger subtree below x, smaller one above it
+                if (x->child[0]) {
+                    tasks.back().x = x->child[0];
+                    tasks.push_back(Task{x, 1});
                 }
+                else
+                    tasks.back().h = 1;
+                if (x->child[1])
+                    tasks.push_back(Task{x->child[1], 0});
+                return 1;
             }
-            if (removed == BLACK && y)
-                DeleteFixUp(y);
-            y = t->fa;
-            if (flag && y)
-                ReplaceChild(y, t, nullptr);
-            delete t;
+            if (compaction->order == VEB_LAYOUT && t.h > 1)
+                return ExpandPiece(tasks.size() - 1);
+            Relocate(t.x, compaction->mem + compaction->next);
+            pool.deallocate(t.x);
+            ++compaction->next;
+            tasks.pop_back();
+            return 1;
+        }
+
+        // a mutation ends a relayout. Under half way through, the nodes
+        // already moved go back to pool (no more work than moving them
+        // took) and mem is freed with fresh; otherwise they stay and the
+        // slots of mem never filled go on the free list. Either way an
+        // interrupted relayout leaves at most half a block unused. Returns
+        // where follow is now
+        Node *AbortCompaction(Node *follow = nullptr) {
+            if (!compaction)
+                return follow;
+            Compaction *c = compaction;
+            if (2 * c->next < c->size) {
+                try {
+                    for (; c->next; --c->next) {
+                        Node *x = c->mem + c->next - 1, *dst = pool.allocate(n);
+                        try {
+                            Relocate(x, dst);
+                        }
+                        catch (...) {
+                            pool.deallocate(dst);
+                            throw;
+                        }
+                        if (x == follow)
+                            follow = dst;
+                    }
+                }
+                catch (...) {}
+            }
+            if (c->next) {
+                pool.adopt(c->fresh);
+                for (size_t i = c->next; i < c->size; ++i)
+                    pool.deallocate(c->mem + i);
+            }
+            delete c;
+            compaction = nullptr;
+            return follow;
         }
 
     public:
@@ -338,22 +876,8 @@ namespace sjtu {
             friend map;
 
             void Move(int c) {
-                if (ptr->child[!c]) {
-                    ptr = ptr->child[!c];
-                    while (ptr->child[c])
-                        ptr = ptr->child[c];
-                }
-                else if (ptr->fa) {
-                    Node *las = ptr;
-                    ptr = ptr->fa;
-                    while (ptr && ptr->ChildNumber(las) == (!c)) {
-                        las = ptr;
-                        ptr = ptr->fa;
-                    }
-                    if (!ptr)
-                        ptr = source->verge;
-                }
-                else
+                ptr = rb_step(ptr, c);
+                if (!ptr)
                     ptr = source->verge;
             }
 
@@ -404,7 +928,7 @@ namespace sjtu {
             }
 
             map::value_type & operator*() const {
-                return *ptr->package;
+                return *ptr->Package();
             }
 
             bool operator==(const iterator &rhs) const {
@@ -423,7 +947,7 @@ namespace sjtu {
             }
 
             map::value_type* operator->() const noexcept {
-                return ptr->package;
+                return ptr->Package();
             }
         };
         class const_iterator {
@@ -434,22 +958,8 @@ namespace sjtu {
             friend map;
 
             void Move(int c) {
-                if (ptr->child[!c]) {
-                    ptr = ptr->child[!c];
-                    while (ptr->child[c])
-                        ptr = ptr->child[c];
-                }
-                else if (ptr->fa) {
-                    const Node *las = ptr;
-                    ptr = ptr->fa;
-                    while (ptr && ptr->ChildNumber(las) == (!c)) {
-                        las = ptr;
-                        ptr = ptr->fa;
-                    }
-                    if (!ptr)
-                        ptr = source->verge;
-                }
-                else
+                ptr = rb_step(ptr, c);
+                if (!ptr)
                     ptr = source->verge;
             }
 
@@ -501,7 +1011,7 @@ namespace sjtu {
             }
 
             const map::value_type & operator*() const {
-                return *ptr->package;
+                return *ptr->Package();
             }
 
             bool operator==(const iterator &rhs) const {
@@ -521,7 +1031,7 @@ namespace sjtu {
             }
 
             const map::value_type* operator->() const noexcept {
-                return ptr->package;
+                return ptr->Package();
             }
         };
 
@@ -539,48 +1049,81 @@ namespace sjtu {
     public:
 
         map() {
-            root = nullptr;
-            verge = new Node;
-            n = 0;
+            Initialize();
         }
-        map(const map &other) {
-            root = nullptr;
-            n = 0;
-            verge = new Node;
-            Construct(root, other.root);
+
+        explicit map(const Allocator &a):pool(NodeAllocator(a)), cold(ColdAllocator(a)) {
+            Initialize();
+        }
+
+        map(const map &other):comp(other.comp),
+                pool(NodeTraits::select_on_container_copy_construction(other.pool.get_allocator())),
+                cold(ColdAllocator(pool.get_allocator())) {
+            Initialize();
+            Copy(other);
+        }
+
+        map(map &&other):comp(other.comp), pool(other.pool.get_allocator()), cold(other.cold.get_allocator()) {
+            pool.swap(other.pool);
+            cold.swap(other.cold);
+            root = other.root;
+            verge = other.verge;
+            n = other.n;
+            graveyard = other.graveyard;
+            compaction = other.compaction;
+            bloom = other.bloom;
+            other.Initialize();
         }
 
         map & operator=(const map &other) {
             if (this == &other)
                 return *this;
-            n = 0;
-            Destruct(root);
-            Construct(root, other.root);
+            Destruct();
+            Copy(other);
             return *this;
         }
 
         ~map() {
-            Destruct(root);
-            delete verge;
+            delete bloom;
+            bloom = nullptr;
+            Destruct();
+            while (graveyard) {
+                Graveyard *g = graveyard;
+                graveyard = g->next;
+                g->Reclaim((size_t)-1);
+                delete g;
+            }
+            NodeAllocator alloc = pool.get_allocator();
+            NodeTraits::deallocate(alloc, verge, 1);
+        }
+
+        map clone(const Allocator &a) const {
+            map res(a);
+            res.Copy(*this);
+            return res;
+        }
+
+        allocator_type get_allocator() const {
+            return allocator_type(pool.get_allocator());
         }
 
         Value & at(const Key &key) {
             Node *x = Find(key);
             if (x == verge)
                 throw index_out_of_bound();
-            return x->package->second;
+            return x->Package()->second;
         }
 
         const Value & at(const Key &key) const {
             Node *x = Find(key);
             if (x == verge)
                 throw index_out_of_bound();
-            return x->package->second;
+            return x->Package()->second;
         }
 
         Value & operator[](const Key &key) {
             Node *x = Insert(key);
-            return x->package->second;
+            return x->Package()->second;
         }
 
         const Value & operator[](const Key &key) const {
@@ -630,16 +1173,129 @@ namespace sjtu {
             return n;
         }
 
+        // lays the next count - size() nodes out in a single block, with
+        // huge_page_allocator that block sits on huge pages
+        void reserve(size_t count) {
+            if (count <= n)
+                return;
+            pool.reserve(count - n);
+            if (SPLIT)
+                cold.reserve(count - n);
+        }
+
         void clear() {
-            n = 0;
-            Destruct(root);
+            Destruct();
+        }
+
+        // moves every node into one fresh block in the given order and
+        // returns the old blocks; iterators are invalidated
+        void compact(map_layout order = IN_ORDER_LAYOUT) {
+            compact_incremental(order);
+            compact_step((size_t)-1);
+        }
+
+        // starts a relayout that compact_step() carries out in slices, the
+        // map stays usable in between but an insert or erase ends it early;
+        // ended under half way, it moves the relocated nodes back and so
+        // invalidates iterators to them
+        void compact_incremental(map_layout order = IN_ORDER_LAYOUT) {
+            AbortCompaction();
+            if (!n)
+                return;
+            Compaction *c = new Compaction(pool.get_allocator(), order);
+            try {
+                c->mem = c->fresh.allocate_block(n);
+                c->size = n;
+                int h = 1;
+                for (Node *x = root; x; x = x->child[1])
+                    h += x->color == BLACK ? 2 : 0;
+                c->tasks.push_back(typename Compaction::Task{root, order == VEB_LAYOUT ? h : 0});
+            }
+            catch (...) {
+                delete c;
+                throw;
+            }
+            compaction = c;
+        }
+
+        // relocates about budget nodes, returns true once no relayout is
+        // pending; iterators to moved nodes are invalidated
+        bool compact_step(size_t budget) {
+            while (compaction && budget) {
+                if (compaction->tasks.empty()) {
+                    pool.release();
+                    pool.swap(compaction->fresh);
+                    delete compaction;
+                    compaction = nullptr;
+                    break;
+                }
+                size_t cost = CompactStep();
+                budget -= budget < cost ? budget : cost;
+            }
+            return !compaction;
+        }
+
+        // empties the map in O(1), the old elements are destroyed later by
+        // reclaim() or by the destructor
+        void clear_deferred() {
+            if (pool.empty())
+                return;
+            Graveyard *g = Detach();
+            g->next = graveyard;
+            graveyard = g;
+        }
+
+        // destroys at most budget deferred nodes (and frees blocks), returns
+        // true once nothing is pending
+        bool reclaim(size_t budget) {
+            while (graveyard && budget) {
+                budget = graveyard->Reclaim(budget);
+                if (graveyard->Done()) {
+                    Graveyard *g = graveyard;
+                    graveyard = g->next;
+                    delete g;
+                }
+            }
+            return !graveyard;
+        }
+
+        // empties the map in O(1) and destroys the old elements on a detached
+        // thread; the allocator and the destructors of Key and Value must be
+        // safe to run there, and the process should not exit while it works
+        void clear_async() {
+            clear_async([]() {});
+        }
+
+        // the same, then calls done() (which must not throw) on that thread
+        // once the elements are destroyed and the blocks freed, so a caller
+        // can wait for it; if no thread can be started the teardown runs
+        // here and done() before this returns
+        template<class Done>
+        void clear_async(Done done) {
+            if (pool.empty()) {
+                done();
+                return;
+            }
+            Graveyard *g = Detach();
+            try {
+                std::thread([g, done]() {
+                    g->Reclaim((size_t)-1);
+                    delete g;
+                    done();
+                }).detach();
+            }
+            catch (...) {
+                g->Reclaim((size_t)-1);
+                delete g;
+                done();
+            }
         }
 
         pair<iterator, bool> insert(const value_type &value) {
             Node *y = Find(value.first);
             if (y == verge) {
                 Node *x = Insert(value.first);
-                x->package->second = value.second;
+                x->Package()->second = value.second;
                 return pair<iterator, bool>(iterator(x, this), true);
             }
             return pair<iterator, bool>(iterator(y, this), false);
@@ -663,6 +1319,85 @@ namespace sjtu {
             return const_iterator(Find(key), this);
         }
 
+        template<class F>
+        void for_each(F f) {
+            Traverse(1, [&f](Node *x) { f(*x->Package()); });
+        }
+
+        template<class F>
+        void for_each(F f) const {
+            Traverse(1, [&f](const Node *x) { f(static_cast<const value_type &>(*x->Package())); });
+        }
+
+        template<class F>
+        void reverse_for_each(F f) {
+            Traverse(0, [&f](Node *x) { f(*x->Package()); });
+        }
+
+        template<class F>
+        void reverse_for_each(F f) const {
+            Traverse(0, [&f](const Node *x) { f(static_cast<const value_type &>(*x->Package())); });
+        }
+
+        template<class F>
+        void for_each_range(const Key &lo, const Key &hi, F f) {
+            Traverse(lo, hi, [&f](Node *x) { f(*x->Package()); });
+        }
+
+        template<class F>
+        void for_each_range(const Key &lo, const Key &hi, F f) const {
+            Traverse(lo, hi, [&f](const Node *x) { f(static_cast<const value_type &>(*x->Package())); });
+        }
+
+        // puts a blocked Bloom filter of the keys in front of find, count,
+        // at and insert, so most lookups of absent keys skip the descent and
+        // its comparisons; it grows with the map and is rebuilt once erased
+        // keys make up half of it. hash must agree with Compare's equality;
+        // should it throw once the filter is on, the filter is dropped
+        template<class Hash = std::hash<Key>>
+        void enable_bloom_filter(const Hash &hash = Hash(), size_t bits_per_key = 16) {
+            bloom_filter<Key> *f = new bloom_filter<Key>(hash, bits_per_key, 2 * n + BLOOM_MIN);
+            try {
+                Traverse(1, [f](Node *x) { f->insert(x->GetKey()); });
+            }
+            catch (...) {
+                delete f;
+                throw;
+            }
+            delete bloom;
+            bloom = f;
+        }
+
+        void disable_bloom_filter() {
+            delete bloom;
+            bloom = nullptr;
+        }
+
+        // estimated share of lookups of absent keys that still descend, 1
+        // without a filter
+        double bloom_false_positive_rate() const {
+            return bloom ? bloom->false_positive_rate() : 1;
+        }
+
+        column_snapshot<Key, Value, Compare> snapshot() const {
+            column_snapshot<Key, Value, Compare> res(n);
+            for_each([&res](const value_type &x) { res.push_back(x.first, x.second); });
+            return res;
+        }
+
+        // frozen copy for find/at/count only, on a minimal perfect hash;
+        // throws runtime_error if two keys have the same hash
+        template<class Hash = std::hash<Key>>
+        hash_snapshot<Key, Value, Hash, Compare> freeze_hash(const Hash &hash = Hash()) const {
+            return hash_snapshot<Key, Value, Hash, Compare>(snapshot(), hash);
+        }
+
+        // frozen copy with a learned index, for integer keys in std::less
+        // order that are spread close to evenly
+        learned_snapshot<Key, Value> freeze_learned(size_t error = 32) const {
+            return learned_snapshot<Key, Value>(snapshot(), error);
+        }
+
         void Debug() {
             Debug(root);
         }
@@ -0,0 +1,211 @@
+#ifndef SJTU_MERKLE_MAP_HPP
+#define SJTU_MERKLE_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "rb_tree.hpp"
+
+namespace sjtu {
+    // merkle_map's Augment: a node keeps the hash of its own (key, value)
+    // and the sum of those hashes over its subtree
+    template<class Key, class Value, class KeyHash, class ValueHash>
+    struct merkle_sum {
+        struct summary {
+            uint64_t own, sum;
+        };
+
+        static const bool trivial_drop = true;
+
+        KeyHash key_hash;
+        ValueHash value_hash;
+
+        static uint64_t Mix(uint64_t x) {
+            x += 0x9e3779b97f4a7c15ull;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+        }
+
+        uint64_t HashOf(const pair<const Key, Value> &x) const {
+            return Mix(Mix(key_hash(x.first)) + value_hash(x.second));
+        }
+
+        template<class Node>
+        void operator()(Node *x) const {
+            x->sum = x->own + (x->child[0] ? x->child[0]->sum : 0) + (x->child[1] ? x->child[1]->sum : 0);
+        }
+
+        template<class Node>
+        void rotated(Node *x, Node *y) const {
+            (*this)(y);
+            (*this)(x);
+        }
+
+        template<class Node>
+        void build(Node *x) const {
+            x->sum = x->own = HashOf(*x->Package());
+        }
+
+        template<class Node>
+        void drop(Node *) const {}
+
+        template<class Node>
+        void copy(Node *x, const Node *y) const {
+            x->sum = y->sum;
+        }
+    };
+
+    // a map for replicas that get compared: an rb_tree whose merkle_sum
+    // Augment keeps every subtree's hash sum current through inserts,
+    // erases, value writes and rotations. A sum does not depend on the
+    // tree's shape, so two maps holding the same elements have the same
+    // digest() however they were built, and diff() can ask the other map
+    // for the digest of any key range in O(log n) and skip the ranges that
+    // agree. Values are read-only through iterators, write them with
+    // insert_or_assign. Equal digests mean equal contents up to a 64-bit
+    // hash collision
+    template<
+            class Key,
+            class Value,
+            class Compare = std::less<Key>,
+            class KeyHash = std::hash<Key>,
+            class ValueHash = std::hash<Value>,
+            class Allocator = std::allocator<pair<const Key, Value>>
+    > class merkle_map : public rb_tree<const pair<const Key, Value>, Key,
+                                        rb_select_first<Key, pair<const Key, Value>>, Compare, Allocator, false,
+                                        merkle_sum<Key, Value, KeyHash, ValueHash>> {
+        typedef rb_tree<const pair<const Key, Value>, Key, rb_select_first<Key, pair<const Key, Value>>,
+                        Compare, Allocator, false, merkle_sum<Key, Value, KeyHash, ValueHash>> Base;
+        typedef typename Base::Node Node;
+
+    public:
+        typedef pair<const Key, Value> value_type;
+        typedef typename Base::iterator iterator;
+        typedef typename Base::const_iterator const_iterator;
+
+    private:
+        using Base::root;
+        using Base::comp;
+        using Base::aug;
+        using Base::MAX_DEPTH;
+
+        // the hash sum of the keys below key (or not above it, when upper)
+        uint64_t Prefix(const Key &key, bool upper) const {
+            uint64_t res = 0;
+            for (Node *x = root; x; )
+                if (upper ? !comp(key, x->GetKey()) : comp(x->GetKey(), key)) {
+                    res += x->own + (x->child[1] ? x->child[1]->sum : 0);
+                    x = x->child[0];
+                }
+                else
+                    x = x->child[1];
+            return res;
+        }
+
+        // the hash sum of the keys strictly between lo and hi, a null bound
+        // is open
+        uint64_t RangeSum(const Key *lo, const Key *hi) const {
+            uint64_t res = hi ? Prefix(*hi, false) : (root ? root->sum : 0);
+            return lo ? res - Prefix(*lo, true) : res;
+        }
+
+    public:
+        using Base::Base;
+
+        const Value & at(const Key &key) const {
+            Node *x = Base::Find(key);
+            if (x == Base::End())
+                throw index_out_of_bound();
+            return x->Package()->second;
+        }
+
+        const_iterator begin() const {
+            return Base::cbegin();
+        }
+
+        const_iterator end() const {
+            return Base::cend();
+        }
+
+        // the sum of the element hashes, the same for any two maps with the
+        // same elements
+        uint64_t digest() const {
+            return root ? root->sum : 0;
+        }
+
+        // O(1), see digest()
+        bool operator==(const merkle_map &other) const {
+            return Base::n == other.n && digest() == other.digest();
+        }
+
+        bool operator!=(const merkle_map &other) const {
+            return !(*this == other);
+        }
+
+        pair<iterator, bool> insert(const value_type &value) {
+            bool found;
+            Node *x = Base::Insert(value, found);
+            return pair<iterator, bool>(iterator(x, this), !found);
+        }
+
+        // sets the value under key, adding the key if it is new; true if
+        // the key was added
+        pair<iterator, bool> insert_or_assign(const Key &key, const Value &value) {
+            bool found;
+            Node *x = Base::Insert(value_type(key, value), found);
+            if (found) {
+                const_cast<value_type *>(x->Package())->second = value;
+                x->own = aug.HashOf(*x->Package());
+                rb_propagate(x, aug);
+            }
+            return pair<iterator, bool>(iterator(x, this), !found);
+        }
+
+        // calls visit(x, y) once per key the maps disagree on, in key order:
+        // x is the element in a and y the one in b, null where the key is
+        // missing. Each subtree of a is checked against the digest of the
+        // same key range in b and skipped when they agree, so the work grows
+        // with the differences (about log^2 n each), not with the size; a
+        // and b must hash alike
+        template<class Visit>
+        static void diff(const merkle_map &a, const merkle_map &b, Visit visit) {
+            // a range of a to check (x may be null), or x alone to report
+            struct Task {
+                const Node *x;
+                const Key *lo, *hi;
+                bool range;
+            } stack[MAX_DEPTH * 2 + 2];
+            int top = 0;
+            stack[top++] = Task{a.root, nullptr, nullptr, true};
+            while (top) {
+                Task t = stack[--top];
+                if (!t.range) {
+                    const Node *y = b.Find(t.x->GetKey());
+                    if (y == b.End())
+                        visit(t.x->Package(), static_cast<const value_type *>(nullptr));
+                    else if (y->own != t.x->own)
+                        visit(t.x->Package(), y->Package());
+                    continue;
+                }
+                if ((t.x ? t.x->sum : 0) == b.RangeSum(t.lo, t.hi))
+                    continue;
+                if (!t.x) {
+                    for (const Node *y = t.lo ? b.Bound(*t.lo, true) : (b.root ? rb_extreme(b.root, 1) : nullptr);
+                         y && y != b.End() && (!t.hi || b.comp(y->GetKey(), *t.hi)); y = rb_step(y, 1))
+                        visit(static_cast<const value_type *>(nullptr), y->Package());
+                    continue;
+                }
+                const Key *key = &t.x->GetKey();
+                stack[top++] = Task{t.x->child[0], key, t.hi, true};
+                stack[top++] = Task{t.x, nullptr, nullptr, false};
+                stack[top++] = Task{t.x->child[1], t.lo, key, true};
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef SJTU_MULTIMAP_HPP
+#define SJTU_MULTIMAP_HPP
+
+#include <functional>
+#include "rb_tree.hpp"
+
+namespace sjtu {
+    // ordered map that keeps every value inserted under a key, equal keys
+    // stay in insertion order and equal_range() walks them
+    template<
+            class Key,
+            class Value,
+            class Compare = std::less<Key>,
+            class Allocator = std::allocator<pair<const Key, Value>>
+    > class multimap : public rb_tree<pair<const Key, Value>, Key, rb_select_first<Key, pair<const Key, Value>>,
+                                      Compare, Allocator, true> {
+        typedef rb_tree<pair<const Key, Value>, Key, rb_select_first<Key, pair<const Key, Value>>,
+                        Compare, Allocator, true> Base;
+
+    public:
+        typedef typename Base::iterator iterator;
+
+        using Base::Base;
+
+        iterator insert(const typename Base::value_type &value) {
+            bool found;
+            return iterator(Base::Insert(value, found), this);
+        }
+    };
+}
+
+#endif
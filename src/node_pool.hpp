@@ -0,0 +1,233 @@
+#ifndef SJTU_NODE_POOL_HPP
+#define SJTU_NODE_POOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace sjtu {
+    // carves nodes out of blocks obtained from Allocator rebound to Node,
+    // freed nodes are chained on a free list through their first bytes.
+    // Every block counts the slots it has out, so a container that shrinks
+    // gives back the blocks it empties: they wait on the free list until
+    // they hold MAX_BLOCK slots and half of the list, then one sweep frees
+    // them. Blocks with a single live node left stay, release returns
+    // everything
+    template<class Node, class Allocator>
+    class node_pool {
+    public:
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> allocator_type;
+
+    private:
+        typedef std::allocator_traits<allocator_type> Traits;
+
+        // used counts the slots handed out or still ahead of the cursor
+        struct Block {
+            Node *mem;
+            size_t size, used;
+        };
+
+        static const size_t MIN_BLOCK = 8;
+        static const size_t MAX_BLOCK = 4096;
+
+        allocator_type alloc;
+        std::vector<Block> blocks; // by address
+        Node *free_list, *cursor, *limit;
+        size_t spare, vacant; // nodes on the free list, slots of unused blocks
+
+        static Node *&Next(Node *x) {
+            return *reinterpret_cast<Node **>(x);
+        }
+
+        static bool Before(const Block &a, const Block &b) {
+            return std::less<Node *>()(a.mem, b.mem);
+        }
+
+        // the block holding x, a branch-free binary search
+        Block &Owner(Node *x) {
+            Block *b = blocks.data();
+            for (size_t len = blocks.size(); len > 1; len -= len / 2)
+                b = std::less<Node *>()(x, b[len / 2].mem) ? b : b + len / 2;
+            return *b;
+        }
+
+        Node *NewBlock(size_t size) {
+            Node *mem = Traits::allocate(alloc, size);
+            Block b{mem, size, size};
+            try {
+                blocks.insert(std::upper_bound(blocks.begin(), blocks.end(), b, Before), b);
+            }
+            catch (...) {
+                Traits::deallocate(alloc, mem, size);
+                throw;
+            }
+            return mem;
+        }
+
+        void Push(Node *x) {
+            Next(x) = free_list;
+            free_list = x;
+            ++spare;
+        }
+
+        // puts x back and counts it off its block
+        void Give(Node *x) {
+            Push(x);
+            Block &b = Owner(x);
+            if (!--b.used)
+                vacant += b.size;
+        }
+
+        // drops the nodes of unused blocks from the free list and frees the
+        // blocks; at least half the list goes, so the walk costs no more
+        // than the deallocations that emptied them
+        void Sweep() {
+            Node **tail = &free_list;
+            spare = 0;
+            for (Node *x = free_list; x; x = Next(x))
+                if (Owner(x).used) {
+                    *tail = x;
+                    tail = &Next(x);
+                    ++spare;
+                }
+            *tail = nullptr;
+            size_t k = 0;
+            for (size_t i = 0; i < blocks.size(); ++i)
+                if (blocks[i].used)
+                    blocks[k++] = blocks[i];
+                else
+                    Traits::deallocate(alloc, blocks[i].mem, blocks[i].size);
+            blocks.resize(k, Block());
+            if (cursor == limit)
+                cursor = limit = nullptr;
+            vacant = 0;
+        }
+
+    public:
+        explicit node_pool(const allocator_type &alloc = allocator_type()):alloc(alloc) {
+            free_list = cursor = limit = nullptr;
+            spare = vacant = 0;
+        }
+
+        node_pool(const node_pool &other) = delete;
+        node_pool & operator=(const node_pool &other) = delete;
+
+        ~node_pool() {
+            release();
+        }
+
+        allocator_type get_allocator() const {
+            return alloc;
+        }
+
+        bool empty() const {
+            return blocks.empty();
+        }
+
+        // hint is the number of live nodes, new blocks grow with it
+        Node *allocate(size_t hint) {
+            Node *x;
+            if (free_list) {
+                x = free_list;
+                free_list = Next(x);
+                --spare;
+                Block &b = Owner(x);
+                if (!b.used++)
+                    vacant -= b.size;
+            }
+            else {
+                if (cursor == limit) {
+                    size_t size = hint < MIN_BLOCK ? MIN_BLOCK : hint > MAX_BLOCK ? MAX_BLOCK : hint;
+                    cursor = NewBlock(size);
+                    limit = cursor + size;
+                }
+                x = cursor++;
+            }
+            return x;
+        }
+
+        void deallocate(Node *x) {
+            Give(x);
+            if (vacant >= MAX_BLOCK && 2 * vacant >= spare)
+                Sweep();
+        }
+
+        // the next count allocations come from one block, whatever is left
+        // of the current block goes on the free list
+        void reserve(size_t count) {
+            if (size_t(limit - cursor) >= count)
+                return;
+            Node *mem = NewBlock(count);
+            while (cursor != limit)
+                Give(cursor++);
+            cursor = mem;
+            limit = mem + count;
+        }
+
+        // a block of exactly size slots that is handed out whole
+        Node *allocate_block(size_t size) {
+            return NewBlock(size);
+        }
+
+        void release() {
+            for (size_t i = 0; i < blocks.size(); ++i)
+                Traits::deallocate(alloc, blocks[i].mem, blocks[i].size);
+            blocks.clear();
+            free_list = cursor = limit = nullptr;
+            spare = vacant = 0;
+        }
+
+        // returns blocks until budget runs out, a block costs about as much
+        // as its pages so it is charged its size; returns what is left
+        size_t release(size_t budget) {
+            while (budget && !blocks.empty()) {
+                Block b = blocks.back();
+                blocks.pop_back();
+                Traits::deallocate(alloc, b.mem, b.size);
+                budget -= budget < b.size ? budget : b.size;
+            }
+            if (blocks.empty()) {
+                free_list = cursor = limit = nullptr;
+                spare = vacant = 0;
+            }
+            return budget;
+        }
+
+        // takes over the blocks of other (same allocator); the slots other
+        // has freed or not yet handed out from its cursor join the free
+        // list, a block it took whole with allocate_block stays the
+        // caller's to account for
+        void adopt(node_pool &other) {
+            blocks.reserve(blocks.size() + other.blocks.size());
+            blocks.insert(blocks.end(), other.blocks.begin(), other.blocks.end());
+            std::inplace_merge(blocks.begin(), blocks.end() - other.blocks.size(), blocks.end(), Before);
+            vacant += other.vacant;
+            while (other.cursor != other.limit)
+                Give(other.cursor++);
+            while (other.free_list) {
+                Node *x = other.free_list;
+                other.free_list = Next(x);
+                Push(x);
+            }
+            other.blocks.clear();
+            other.cursor = other.limit = nullptr;
+            other.spare = other.vacant = 0;
+            if (vacant >= MAX_BLOCK && 2 * vacant >= spare)
+                Sweep();
+        }
+
+        void swap(node_pool &other) {
+            std::swap(alloc, other.alloc);
+            blocks.swap(other.blocks);
+            std::swap(free_list, other.free_list);
+            std::swap(cursor, other.cursor);
+            std::swap(limit, other.limit);
+            std::swap(spare, other.spare);
+            std::swap(vacant, other.vacant);
+        }
+    };
+}
+
+#endif
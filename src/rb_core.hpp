@@ -0,0 +1,290 @@
+#ifndef SJTU_RB_CORE_HPP
+#define SJTU_RB_CORE_HPP
+
+#include <type_traits>
+#include <utility>
+
+namespace sjtu {
+    // the red-black algorithms every tree here shares: a Node is anything
+    // with child[2], fa and color, child[1] holds the smaller keys and the
+    // root has no fa. Nothing below allocates, compares keys or touches a
+    // payload, so the same code runs on map's nodes and on intrusive ones.
+    // A tree that keeps a per-subtree summary passes an Augment, which is
+    // called on a node to recompute its summary from its children and told
+    // by rotated(x, y) that x was just lifted over y
+    enum rb_color {RB_RED, RB_BLACK};
+
+    // also the empty Augment of rb_tree, see there for the members it adds
+    struct rb_no_augment {
+        struct summary {};
+
+        static const bool trivial_drop = true;
+
+        template<class Node>
+        void operator()(Node *) const {}
+
+        template<class Node>
+        void rotated(Node *, Node *) const {}
+
+        template<class Node>
+        void build(Node *) const {}
+
+        template<class Node>
+        void drop(Node *) const {}
+
+        template<class Node>
+        void copy(Node *, const Node *) const {}
+    };
+
+    // recomputes x and every node above it
+    template<class Node, class Augment>
+    void rb_propagate(Node *x, const Augment &aug) {
+        for (; x; x = x->fa)
+            aug(x);
+    }
+
+    // key extractors for trees that store a bare key or a pair
+    template<class Key>
+    struct rb_identity {
+        const Key &operator()(const Key &key) const {
+            return key;
+        }
+    };
+
+    template<class Key, class Pair>
+    struct rb_select_first {
+        const Key &operator()(const Pair &value) const {
+            return value.first;
+        }
+    };
+
+    template<class Node>
+    bool rb_child_number(const Node *x, const Node *y) {
+        return y == x->child[1];
+    }
+
+    // null children count as black
+    template<class Node>
+    bool rb_is(const Node *x, rb_color color) {
+        if (!x)
+            return color == RB_BLACK;
+        return x->color == color;
+    }
+
+    // the last node going down child[c] from x
+    template<class Node>
+    Node *rb_extreme(Node *x, int c) {
+        while (x->child[c])
+            x = x->child[c];
+        return x;
+    }
+
+    // the in-order neighbour of x, c = 1 for the next larger key, null past
+    // either end
+    template<class Node>
+    Node *rb_step(Node *x, int c) {
+        if (x->child[!c])
+            return rb_extreme(x->child[!c], c);
+        Node *las = x;
+        x = x->fa;
+        while (x && rb_child_number(x, las) == !c) {
+            las = x;
+            x = x->fa;
+        }
+        return x;
+    }
+
+    // lifts x above its parent
+    template<class Node, class Augment = rb_no_augment>
+    void rb_rotate(Node *x, Node *&root, const Augment &aug = Augment()) {
+        Node *y = x->fa, *w = y->fa;
+        bool c = rb_child_number(y, x);
+        Node *z = x->child[!c];
+        x->child[!c] = y;
+        y->child[c] = z;
+        x->fa = w;
+        y->fa = x;
+        if (z)
+            z->fa = y;
+        if (w)
+            w->child[rb_child_number(w, y)] = x;
+        if (!x->fa)
+            root = x;
+        aug.rotated(x, y);
+    }
+
+    // x has just been hung as a red leaf (or is the new root), with its
+    // ancestors already propagated when augmented
+    template<class Node, class Augment = rb_no_augment>
+    void rb_insert_fixup(Node *x, Node *&root, const Augment &aug = Augment()) {
+        if (!x->fa) {
+            x->color = RB_BLACK;
+            return;
+        }
+        while (true) {
+            Node *y = x->fa; // y can't be nullptr
+            if (y->color == RB_BLACK)
+                break;
+            Node *z = y->fa; // z can't be nullptr
+            bool c = rb_child_number(z, y);
+            if (rb_is(z->child[!c], RB_RED)) { // situation 1
+                z->color = RB_RED;
+                y->color = RB_BLACK;
+                z->child[!c]->color = RB_BLACK;
+                if (z == root) {
+                    z->color = RB_BLACK;
+                    break;
+                }
+                x = z;
+            }
+            else if (rb_child_number(z, y) == rb_child_number(y, x)) { // situation 2
+                rb_rotate(y, root, aug);
+                y->color = RB_BLACK;
+                if (y->child[!c])
+                    y->child[!c]->color = RB_RED;
+                break;
+            }
+            else {
+                rb_rotate(x, root, aug);
+                rb_rotate(x, root, aug);
+                x->color = RB_BLACK;
+                z->color = RB_RED;
+                break;
+            }
+        }
+    }
+
+    // puts y (not null) where x hangs
+    template<class Node>
+    void rb_transplant(Node *x, Node *y, Node *&root) {
+        Node *z = x->fa;
+        if (!z)
+            root = y;
+        else
+            z->child[rb_child_number(z, x)] = y;
+        y->fa = z;
+    }
+
+    template<class Node, class Augment>
+    void rb_erase_fixup(Node *x, Node *&root, const Augment &aug) {
+        if (x->color == RB_RED || x == root) {
+            x->color = RB_BLACK;
+            return;
+        }
+        Node *y = x->fa, *z = y->child[!rb_child_number(y, x)];
+        int c = rb_child_number(y, x);
+        while (true) {
+            if (x->color == RB_RED) {
+                x->color = RB_BLACK;
+                break;
+            }
+            if (x == root)
+                break;
+            if (rb_is(z, RB_RED)) {
+                z->color = RB_BLACK;
+                y->color = RB_RED;
+                rb_rotate(z, root, aug);
+                y = x->fa, c = rb_child_number(y, x), z = y->child[!c];
+            }
+            if (rb_is(z->child[0], RB_BLACK) && rb_is(z->child[1], RB_BLACK)) {
+                z->color = RB_RED;
+                x = y, y = x->fa;
+                if (y)
+                    c = rb_child_number(y, x), z = y->child[!c];
+                continue;
+            }
+            if (rb_is(z->child[c], RB_RED) && rb_is(z->child[!c], RB_BLACK)) {
+                z->child[c]->color = RB_BLACK;
+                z->color = RB_RED;
+                rb_rotate(z->child[c], root, aug);
+                y = x->fa, c = rb_child_number(y, x), z = y->child[!c];
+            }
+            if (rb_is(z->child[!c], RB_RED)) {
+                z->color = y->color;
+                y->color = RB_BLACK;
+                z->child[!c]->color = RB_BLACK;
+                rb_rotate(z, root, aug);
+                break;
+            }
+        }
+    }
+
+    template<class Node>
+    void rb_replace_child(Node *x, Node *y, Node *z) {
+        if (x)
+            x->child[rb_child_number(x, y)] = z;
+    }
+
+    template<class Node>
+    void rb_set_fa(Node *x, Node *y) {
+        if (x)
+            x->fa = y;
+    }
+
+    // unlinks x and rebalances; a node with two children first trades
+    // places (not payloads) with its in-order predecessor, so every other
+    // node stays where it is. Only nodes above the spot x leaves from can
+    // hold a stale summary afterwards (rotations recompute the rest), so
+    // that path is propagated last
+    template<class Node, class Augment = rb_no_augment>
+    void rb_erase(Node *x, Node *&root, const Augment &aug = Augment()) {
+        Node *y, *t;
+        rb_color removed;
+        bool flag = false; // delay removing it from tree
+        if (x == root && !x->child[0] && !x->child[1]) {
+            root = nullptr;
+            return;
+        }
+        if (!x->child[0] && !x->child[1]) {
+            removed = x->color;
+            t = y = x;
+            flag = true;
+        }
+        else if (!x->child[0] || !x->child[1]) {
+            removed = x->color;
+            y = x->child[(x->child[1] != nullptr)];
+            rb_transplant(t = x, y, root);
+        }
+        else {
+            Node *z = rb_extreme(x->child[1], 0);
+            std::swap(x->color, z->color);
+            rb_set_fa(x->child[0], z);
+            rb_set_fa(z->child[1], x);
+            if (z->fa == x) {
+                z->fa = x->fa;
+                x->fa = z;
+                std::swap(x->child, z->child);
+                z->child[1] = x;
+                rb_replace_child(z->fa, x, z);
+            }
+            else {
+                rb_set_fa(x->child[1], z);
+                rb_replace_child(x->fa, x, z);
+                rb_replace_child(z->fa, z, x);
+                std::swap(x->child, z->child);
+                std::swap(x->fa, z->fa);
+            }
+            if (!z->fa)
+                root = z;
+            removed = x->color;
+            if (!x->child[1]) {
+                t = y = x;
+                flag = true;
+            }
+            else {
+                y = x->child[1];
+                rb_transplant(t = x, y, root);
+            }
+        }
+        if (removed == RB_BLACK && y)
+            rb_erase_fixup(y, root, aug);
+        Node *stale = flag ? t->fa : y;
+        y = t->fa;
+        if (flag && y)
+            rb_replace_child(y, t, (Node *)nullptr);
+        if (!std::is_same<Augment, rb_no_augment>::value)
+            rb_propagate(stale, aug);
+    }
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef SJTU_RB_ITERATOR_HPP
+#define SJTU_RB_ITERATOR_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "rb_core.hpp"
+
+namespace sjtu {
+    // the iterator of the trees whose nodes climb by fa (rb_tree,
+    // splay_map, string_map): it steps with rb_step and stands on
+    // source->End() past the last element, Tree befriends it for End() and
+    // root. Node is const in a const_iterator and * hands out Value. A tree
+    // that adds accessors derives Self from it, so ++ and -- return Self
+    template<class Tree, class Node, class Value, class Self = void>
+    class rb_iterator {
+    private:
+        typedef typename std::conditional<std::is_void<Self>::value, rb_iterator, Self>::type Derived;
+
+        template<class, class, class, class> friend class rb_iterator;
+        friend Tree;
+
+    protected:
+        Node *ptr;
+        const Tree *source;
+
+    public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = typename std::remove_const<Value>::type;
+        using pointer = Value*;
+        using reference = Value&;
+        using iterator_category = std::output_iterator_tag;
+        using iterator_assignable = typename std::conditional<
+                std::is_const<Value>::value, my_false_type, my_true_type>::type;
+
+        rb_iterator():ptr(nullptr), source(nullptr) {}
+
+        rb_iterator(Node *ptr, const Tree *source):ptr(ptr), source(source) {}
+
+        // iterator to const_iterator
+        template<class N, class V, class S>
+        rb_iterator(const rb_iterator<Tree, N, V, S> &other):ptr(other.ptr), source(other.source) {}
+
+        Derived operator++(int) {
+            Derived res = static_cast<Derived &>(*this);
+            operator++();
+            return res;
+        }
+
+        Derived & operator++() {
+            if (!source || ptr == source->End())
+                throw invalid_iterator();
+            ptr = rb_step(ptr, 1);
+            if (!ptr)
+                ptr = source->End();
+            return static_cast<Derived &>(*this);
+        }
+
+        Derived operator--(int) {
+            Derived res = static_cast<Derived &>(*this);
+            operator--();
+            return res;
+        }
+
+        Derived & operator--() {
+            if (!source)
+                throw invalid_iterator();
+            Node *x = ptr == source->End() ? (source->root ? rb_extreme(source->root, 0) : nullptr)
+                                           : rb_step(ptr, 0);
+            if (!x)
+                throw invalid_iterator();
+            ptr = x;
+            return static_cast<Derived &>(*this);
+        }
+
+        Value & operator*() const {
+            return *ptr->Package();
+        }
+
+        Value* operator->() const noexcept {
+            return ptr->Package();
+        }
+
+        template<class N, class V, class S>
+        bool operator==(const rb_iterator<Tree, N, V, S> &rhs) const {
+            return ptr == rhs.ptr;
+        }
+
+        template<class N, class V, class S>
+        bool operator!=(const rb_iterator<Tree, N, V, S> &rhs) const {
+            return ptr != rhs.ptr;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,380 @@
+#ifndef SJTU_RB_TREE_HPP
+#define SJTU_RB_TREE_HPP
+
+#include <functional>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "node_pool.hpp"
+#include "rb_core.hpp"
+#include "rb_iterator.hpp"
+
+namespace sjtu {
+    // the container half of set, multiset, multimap, merkle_map and
+    // interval_map: nodes hold the links and a Value, KeyOf reads the key
+    // out of it and Multi lets equal keys in, after the ones already there.
+    // The balancing itself is rb_core, the same code map runs on. Value is
+    // const for the sets so their iterators never hand out a mutable key.
+    // A tree with a per-subtree summary passes an Augment: its summary is
+    // raw bytes every node carries, build(x) fills them in for a node whose
+    // Value was just built (it may throw), copy(x, y) takes them from y in
+    // a tree of the same shape, drop(x) ends them before the Value goes
+    // (it can be skipped when trivial_drop), and calling it on x recomputes
+    // x's summary from its children and rotated(x, y) fixes up a rotation,
+    // as rb_core expects
+    template<
+            class Value,
+            class Key,
+            class KeyOf,
+            class Compare,
+            class Allocator,
+            bool Multi,
+            class Augment = rb_no_augment
+    > class rb_tree {
+    public:
+        typedef Value value_type;
+        typedef Allocator allocator_type;
+
+    protected:
+        typedef typename std::remove_const<Value>::type Stored;
+
+        class Node : public Augment::summary {
+        public:
+            Node *child[2];
+            Node *fa;
+            rb_color color;
+            alignas(Stored) unsigned char storage[sizeof(Stored)];
+
+            Value *Package() {
+                return reinterpret_cast<Value *>(storage);
+            }
+
+            const Value *Package() const {
+                return reinterpret_cast<const Value *>(storage);
+            }
+
+            const Key &GetKey() const {
+                return KeyOf()(*Package());
+            }
+        };
+
+        typedef node_pool<Node, Allocator> Pool;
+
+        // the height of a red-black tree is at most 2 * log2(n + 1)
+        static const int MAX_DEPTH = 128;
+
+        template<class, class, class, class> friend class rb_iterator;
+
+        Compare comp;
+        Augment aug;
+        Pool pool;
+        Node *root;
+        Node verge; // end(), its package is never built
+        size_t n;
+
+        bool Equal(const Key &a, const Key &b) const {
+            return !comp(a, b) && !comp(b, a);
+        }
+
+        Node *NewNode(const Value &value) {
+            Node *x = pool.allocate(n);
+            try {
+                new (x->storage) Stored(value);
+            }
+            catch (...) {
+                pool.deallocate(x);
+                throw;
+            }
+            try {
+                aug.build(x);
+            }
+            catch (...) {
+                x->Package()->~Value();
+                pool.deallocate(x);
+                throw;
+            }
+            x->color = RB_RED;
+            x->fa = x->child[0] = x->child[1] = nullptr;
+            return x;
+        }
+
+        void DeleteNode(Node *x) {
+            aug.drop(x);
+            x->Package()->~Value();
+            pool.deallocate(x);
+        }
+
+        Node *End() const {
+            return const_cast<Node *>(&verge);
+        }
+
+        // returns the node with an equal key instead of adding when !Multi
+        Node *Insert(const Value &value, bool &found) {
+            const Key &key = KeyOf()(value);
+            Node *x = root, *y = nullptr;
+            bool c = false;
+            found = false;
+            while (x) {
+                if (!Multi && Equal(key, x->GetKey())) {
+                    found = true;
+                    return x;
+                }
+                y = x;
+                c = comp(key, x->GetKey());
+                x = x->child[c];
+            }
+            x = NewNode(value);
+            x->fa = y;
+            if (y)
+                y->child[c] = x;
+            else
+                root = x;
+            if (!std::is_same<Augment, rb_no_augment>::value)
+                rb_propagate(y, aug);
+            rb_insert_fixup(x, root, aug);
+            ++n;
+            return x;
+        }
+
+        void Delete(Node *x) {
+            rb_erase(x, root, aug);
+            DeleteNode(x);
+            --n;
+        }
+
+        // the first node whose key is not below key (upper: above key)
+        Node *Bound(const Key &key, bool upper) const {
+            Node *x = root, *res = End();
+            while (x) {
+                if (upper ? comp(key, x->GetKey()) : !comp(x->GetKey(), key)) {
+                    res = x;
+                    x = x->child[1];
+                }
+                else
+                    x = x->child[0];
+            }
+            return res;
+        }
+
+        Node *Find(const Key &key) const {
+            if (!Multi) {
+                Node *x = root;
+                while (x) {
+                    if (Equal(key, x->GetKey()))
+                        return x;
+                    x = x->child[comp(key, x->GetKey())];
+                }
+                return End();
+            }
+            Node *x = Bound(key, false);
+            return x != End() && !comp(key, x->GetKey()) ? x : End();
+        }
+
+        // preorder copy of other into one block, every node is linked as
+        // soon as its package is built so a throwing copy still leaves a
+        // tree to free; the shape is the same, so colors and summaries
+        // carry over
+        void Copy(const rb_tree &other) {
+            if (!other.root)
+                return;
+            pool.reserve(other.n);
+            const Node *src[MAX_DEPTH + 1];
+            Node *dst[MAX_DEPTH + 1];
+            int top = 0;
+            try {
+                root = NewNode(*other.root->Package());
+                root->color = other.root->color;
+                aug.copy(root, other.root);
+                src[top] = other.root;
+                dst[top++] = root;
+                while (top) {
+                    --top;
+                    const Node *s = src[top];
+                    Node *d = dst[top];
+                    for (int c = 0; c < 2; ++c)
+                        if (s->child[c]) {
+                            Node *e = NewNode(*s->child[c]->Package());
+                            e->color = s->child[c]->color;
+                            e->fa = d;
+                            d->child[c] = e;
+                            aug.copy(e, s->child[c]);
+                            src[top] = s->child[c];
+                            dst[top++] = e;
+                        }
+                }
+            }
+            catch (...) {
+                Destruct();
+                throw;
+            }
+            n = other.n;
+        }
+
+        void Destruct() {
+            if (!(std::is_trivially_destructible<Stored>::value && Augment::trivial_drop) && root) {
+                Node *stack[MAX_DEPTH + 1];
+                int top = 0;
+                stack[top++] = root;
+                while (top) {
+                    Node *x = stack[--top];
+                    if (x->child[0])
+                        stack[top++] = x->child[0];
+                    if (x->child[1])
+                        stack[top++] = x->child[1];
+                    aug.drop(x);
+                    x->Package()->~Value();
+                }
+            }
+            pool.release();
+            root = nullptr;
+            n = 0;
+        }
+
+        void Initialize() {
+            root = nullptr;
+            n = 0;
+            verge.fa = verge.child[0] = verge.child[1] = nullptr;
+        }
+
+    public:
+        typedef rb_iterator<rb_tree, Node, Value> iterator;
+        typedef rb_iterator<rb_tree, const Node, const Value> const_iterator;
+
+    protected:
+        // the element pos stands on, which has to be one of this tree's
+        Node *NodeOf(const_iterator pos) const {
+            if (pos.source != this || pos.ptr == End())
+                throw invalid_iterator();
+            return const_cast<Node *>(pos.ptr);
+        }
+
+    public:
+
+        rb_tree() {
+            Initialize();
+        }
+
+        explicit rb_tree(const Allocator &a):pool(typename Pool::allocator_type(a)) {
+            Initialize();
+        }
+
+        rb_tree(const rb_tree &other):comp(other.comp), aug(other.aug), pool(std::allocator_traits<typename Pool::allocator_type>::
+                select_on_container_copy_construction(other.pool.get_allocator())) {
+            Initialize();
+            Copy(other);
+        }
+
+        // end() of other does not carry over, it stays with other
+        rb_tree(rb_tree &&other):comp(other.comp), aug(other.aug), pool(other.pool.get_allocator()) {
+            Initialize();
+            pool.swap(other.pool);
+            root = other.root;
+            n = other.n;
+            other.Initialize();
+        }
+
+        rb_tree & operator=(const rb_tree &other) {
+            if (this == &other)
+                return *this;
+            Destruct();
+            Copy(other);
+            return *this;
+        }
+
+        ~rb_tree() {
+            Destruct();
+        }
+
+        allocator_type get_allocator() const {
+            return allocator_type(pool.get_allocator());
+        }
+
+        iterator begin() {
+            return iterator(root ? rb_extreme(root, 1) : End(), this);
+        }
+
+        const_iterator cbegin() const {
+            return const_iterator(root ? rb_extreme(root, 1) : End(), this);
+        }
+
+        iterator end() {
+            return iterator(End(), this);
+        }
+
+        const_iterator cend() const {
+            return const_iterator(End(), this);
+        }
+
+        bool empty() const {
+            return !n;
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        void clear() {
+            Destruct();
+        }
+
+        void erase(const_iterator pos) {
+            Delete(NodeOf(pos));
+        }
+
+        // removes every element with this key, returns how many went
+        size_t erase(const Key &key) {
+            size_t res = 0;
+            for (Node *x = Find(key); x != End(); x = Find(key), ++res)
+                Delete(x);
+            return res;
+        }
+
+        size_t count(const Key &key) const {
+            if (!Multi)
+                return Find(key) != End();
+            size_t res = 0;
+            for (const Node *x = Find(key); x && x != End() && !comp(key, x->GetKey()); x = rb_step(x, 1))
+                ++res;
+            return res;
+        }
+
+        iterator find(const Key &key) {
+            return iterator(Find(key), this);
+        }
+
+        const_iterator find(const Key &key) const {
+            return const_iterator(Find(key), this);
+        }
+
+        iterator lower_bound(const Key &key) {
+            return iterator(Bound(key, false), this);
+        }
+
+        const_iterator lower_bound(const Key &key) const {
+            return const_iterator(Bound(key, false), this);
+        }
+
+        iterator upper_bound(const Key &key) {
+            return iterator(Bound(key, true), this);
+        }
+
+        const_iterator upper_bound(const Key &key) const {
+            return const_iterator(Bound(key, true), this);
+        }
+
+        // the elements with this key, [first, second)
+        pair<iterator, iterator> equal_range(const Key &key) {
+            return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+        }
+
+        pair<const_iterator, const_iterator> equal_range(const Key &key) const {
+            return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+        }
+    };
+}
+
+#endif
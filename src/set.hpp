@@ -0,0 +1,48 @@
+#ifndef SJTU_SET_HPP
+#define SJTU_SET_HPP
+
+#include <functional>
+#include "rb_tree.hpp"
+
+namespace sjtu {
+    // ordered set of unique keys, a node is the links plus one Key
+    template<
+            class Key,
+            class Compare = std::less<Key>,
+            class Allocator = std::allocator<Key>
+    > class set : public rb_tree<const Key, Key, rb_identity<Key>, Compare, Allocator, false> {
+        typedef rb_tree<const Key, Key, rb_identity<Key>, Compare, Allocator, false> Base;
+
+    public:
+        typedef typename Base::iterator iterator;
+
+        using Base::Base;
+
+        pair<iterator, bool> insert(const Key &key) {
+            bool found;
+            typename Base::Node *x = Base::Insert(key, found);
+            return pair<iterator, bool>(iterator(x, this), !found);
+        }
+    };
+
+    // ordered set that keeps equal keys, in the order they were inserted
+    template<
+            class Key,
+            class Compare = std::less<Key>,
+            class Allocator = std::allocator<Key>
+    > class multiset : public rb_tree<const Key, Key, rb_identity<Key>, Compare, Allocator, true> {
+        typedef rb_tree<const Key, Key, rb_identity<Key>, Compare, Allocator, true> Base;
+
+    public:
+        typedef typename Base::iterator iterator;
+
+        using Base::Base;
+
+        iterator insert(const Key &key) {
+            bool found;
+            return iterator(Base::Insert(key, found), this);
+        }
+    };
+}
+
+#endif
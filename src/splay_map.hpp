@@ -0,0 +1,407 @@
+#ifndef SJTU_SPLAY_MAP_HPP
+#define SJTU_SPLAY_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "node_pool.hpp"
+#include "rb_core.hpp"
+#include "rb_iterator.hpp"
+
+namespace sjtu {
+    // how far splay_map moves an accessed node: FULL_SPLAY all the way to
+    // the root, SEMI_SPLAY about halfway up with half the rotations
+    enum splay_policy {FULL_SPLAY, SEMI_SPLAY};
+
+    // map's interface on a splay tree: every lookup, insert and erase
+    // rotates the node it reaches toward the root (rb_rotate, there are no
+    // colors), so under skewed traffic the hot keys live a few levels down
+    // instead of at depth log n. Bounds are amortized, a single operation
+    // can walk a long path. The rotations write on every access, so this
+    // only pays under strong skew: against map on 1M int keys it is 1.4-2x
+    // faster at Zipf s = 1.5, a little slower near s = 1.2 and 3-4x slower
+    // on uniform traffic, see test/splay_speedtest.cpp. Lookups
+    // restructure the tree, const ones included, so readers need exclusive
+    // access too. Nothing here uses a stack, the tree has no depth limit
+    template<
+            class Key,
+            class Value,
+            class Compare = std::less<Key>,
+            class Allocator = std::allocator<pair<const Key, Value>>,
+            splay_policy Policy = SEMI_SPLAY
+    > class splay_map {
+    public:
+        typedef pair<const Key, Value> value_type;
+
+    private:
+        class Node {
+        public:
+            Node *child[2];
+            Node *fa;
+            alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+            value_type *Package() {
+                return reinterpret_cast<value_type *>(storage);
+            }
+
+            const value_type *Package() const {
+                return reinterpret_cast<const value_type *>(storage);
+            }
+
+            const Key &GetKey() const {
+                return Package()->first;
+            }
+        };
+
+        typedef node_pool<Node, Allocator> Pool;
+
+        template<class, class, class, class> friend class rb_iterator;
+
+        Compare comp;
+        Pool pool;
+        mutable Node *root;
+        Node *verge;
+        size_t n;
+
+        Node *End() const {
+            return verge;
+        }
+
+        bool Equal(const Key &a, const Key &b) const {
+            return !comp(a, b) && !comp(b, a);
+        }
+
+        Node *NewNode(const Key &key, const Value &value) {
+            Node *x = pool.allocate(n);
+            try {
+                new (x->storage) value_type(key, value);
+            }
+            catch (...) {
+                pool.deallocate(x);
+                throw;
+            }
+            x->fa = x->child[0] = x->child[1] = nullptr;
+            return x;
+        }
+
+        void DeleteNode(Node *x) {
+            x->Package()->~value_type();
+            pool.deallocate(x);
+        }
+
+        // lifts x to the root of the tree top points to
+        static void Splay(Node *x, Node *&top) {
+            while (x->fa) {
+                Node *y = x->fa, *z = y->fa;
+                if (z && rb_child_number(z, y) == rb_child_number(y, x))
+                    rb_rotate(y, top);
+                else if (z)
+                    rb_rotate(x, top);
+                rb_rotate(x, top);
+            }
+        }
+
+        // a straight pair of links turns once and the walk goes on from
+        // the middle node, a bent pair turns x up twice; x ends about
+        // halfway to the root and the path about half as long
+        static void SemiSplay(Node *x, Node *&top) {
+            while (x->fa && x->fa->fa) {
+                Node *y = x->fa, *z = y->fa;
+                if (rb_child_number(z, y) == rb_child_number(y, x)) {
+                    rb_rotate(y, top);
+                    x = y;
+                }
+                else {
+                    rb_rotate(x, top);
+                    rb_rotate(x, top);
+                }
+            }
+        }
+
+        void Access(Node *x) const {
+            if (Policy == FULL_SPLAY)
+                Splay(x, root);
+            else
+                SemiSplay(x, root);
+        }
+
+        // the node with key or verge; the last node on the path is splayed
+        // either way
+        Node *Find(const Key &key) const {
+            Node *x = root, *y = nullptr;
+            while (x) {
+                y = x;
+                if (Equal(key, x->GetKey()))
+                    break;
+                x = x->child[comp(key, x->GetKey())];
+            }
+            if (y)
+                Access(y);
+            return x ? x : verge;
+        }
+
+        // the node reached, old or new (found tells which), ends up splayed
+        Node *Insert(const Key &key, const Value &value, bool &found) {
+            Node *x = root, *y = nullptr;
+            bool c = false;
+            found = false;
+            while (x) {
+                if (Equal(key, x->GetKey())) {
+                    found = true;
+                    Access(x);
+                    return x;
+                }
+                y = x;
+                c = comp(key, x->GetKey());
+                x = x->child[c];
+            }
+            x = NewNode(key, value);
+            x->fa = y;
+            if (y)
+                y->child[c] = x;
+            else
+                root = x;
+            ++n;
+            Access(x);
+            return x;
+        }
+
+        // x goes to the root, then the largest of its smaller keys takes
+        // its place
+        void Delete(Node *x) {
+            Splay(x, root);
+            Node *l = x->child[1], *r = x->child[0];
+            if (!l) {
+                root = r;
+                rb_set_fa(r, (Node *)nullptr);
+            }
+            else {
+                l->fa = nullptr;
+                Splay(rb_extreme(l, 0), l);
+                l->child[0] = r;
+                rb_set_fa(r, l);
+                root = l;
+            }
+            DeleteNode(x);
+            --n;
+        }
+
+        // frees the tree by rotating child[1] up, so no stack is needed
+        void Destruct() {
+            Node *x = root;
+            if (!std::is_trivially_destructible<value_type>::value)
+                while (x) {
+                    Node *y = x->child[1];
+                    if (y) {
+                        x->child[1] = y->child[0];
+                        y->child[0] = x;
+                        x = y;
+                    }
+                    else {
+                        y = x->child[0];
+                        x->Package()->~value_type();
+                        x = y;
+                    }
+                }
+            pool.release();
+            root = nullptr;
+            n = 0;
+        }
+
+        // in-order walk by climbing fa, it leaves the shape alone; c is the
+        // side visited first (1 for ascending order)
+        template<class Visit>
+        void Traverse(bool c, Visit visit) const {
+            for (Node *x = root ? rb_extreme(root, c) : nullptr; x; x = rb_step(x, c))
+                visit(x);
+        }
+
+        Node *CloneNode(const Node *s, Node *fa) {
+            Node *x = NewNode(s->GetKey(), s->Package()->second);
+            x->fa = fa;
+            return x;
+        }
+
+        // preorder copy that climbs fa instead of keeping a stack, every
+        // node is linked as soon as it is built
+        void Copy(const splay_map &other) {
+            if (!other.root)
+                return;
+            pool.reserve(other.n);
+            try {
+                const Node *s = other.root;
+                Node *d = root = CloneNode(s, nullptr);
+                while (s) {
+                    int c = s->child[0] ? 0 : 1;
+                    if (s->child[c]) {
+                        d = d->child[c] = CloneNode(s->child[c], d);
+                        s = s->child[c];
+                        continue;
+                    }
+                    // up to the first node whose child[1] is still to copy
+                    while (true) {
+                        const Node *t = s->fa;
+                        if (!t) {
+                            s = nullptr;
+                            break;
+                        }
+                        if (t->child[0] == s && t->child[1]) {
+                            d = d->fa->child[1] = CloneNode(t->child[1], d->fa);
+                            s = t->child[1];
+                            break;
+                        }
+                        s = t;
+                        d = d->fa;
+                    }
+                }
+            }
+            catch (...) {
+                Destruct();
+                throw;
+            }
+            n = other.n;
+        }
+
+        void Initialize() {
+            root = nullptr;
+            n = 0;
+            verge = static_cast<Node *>(::operator new(sizeof(Node)));
+            verge->fa = verge->child[0] = verge->child[1] = nullptr;
+        }
+
+    public:
+        typedef rb_iterator<splay_map, Node, value_type> iterator;
+        typedef rb_iterator<splay_map, const Node, const value_type> const_iterator;
+
+        splay_map() {
+            Initialize();
+        }
+
+        splay_map(const splay_map &other):comp(other.comp) {
+            Initialize();
+            Copy(other);
+        }
+
+        splay_map(splay_map &&other):comp(other.comp) {
+            pool.swap(other.pool);
+            root = other.root;
+            verge = other.verge;
+            n = other.n;
+            other.Initialize();
+        }
+
+        splay_map & operator=(const splay_map &other) {
+            if (this == &other)
+                return *this;
+            Destruct();
+            Copy(other);
+            return *this;
+        }
+
+        ~splay_map() {
+            Destruct();
+            ::operator delete(verge);
+        }
+
+        Value & at(const Key &key) {
+            Node *x = Find(key);
+            if (x == verge)
+                throw index_out_of_bound();
+            return x->Package()->second;
+        }
+
+        const Value & at(const Key &key) const {
+            Node *x = Find(key);
+            if (x == verge)
+                throw index_out_of_bound();
+            return x->Package()->second;
+        }
+
+        Value & operator[](const Key &key) {
+            bool found;
+            return Insert(key, Value(), found)->Package()->second;
+        }
+
+        const Value & operator[](const Key &key) const {
+            return at(key);
+        }
+
+        iterator begin() {
+            return iterator(root ? rb_extreme(root, 1) : verge, this);
+        }
+
+        const_iterator cbegin() const {
+            return const_iterator(root ? rb_extreme(root, 1) : verge, this);
+        }
+
+        iterator end() {
+            return iterator(verge, this);
+        }
+
+        const_iterator cend() const {
+            return const_iterator(verge, this);
+        }
+
+        bool empty() const {
+            return !n;
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        void clear() {
+            Destruct();
+        }
+
+        pair<iterator, bool> insert(const value_type &value) {
+            bool found;
+            Node *x = Insert(value.first, value.second, found);
+            return pair<iterator, bool>(iterator(x, this), !found);
+        }
+
+        void erase(iterator pos) {
+            if (pos.source != this || pos.ptr == verge)
+                throw invalid_iterator();
+            Delete(pos.ptr);
+        }
+
+        size_t count(const Key &key) const {
+            return Find(key) != verge;
+        }
+
+        iterator find(const Key &key) {
+            return iterator(Find(key), this);
+        }
+
+        const_iterator find(const Key &key) const {
+            return const_iterator(Find(key), this);
+        }
+
+        template<class F>
+        void for_each(F f) {
+            Traverse(1, [&f](Node *x) { f(*x->Package()); });
+        }
+
+        template<class F>
+        void for_each(F f) const {
+            Traverse(1, [&f](const Node *x) { f(static_cast<const value_type &>(*x->Package())); });
+        }
+
+        template<class F>
+        void reverse_for_each(F f) {
+            Traverse(0, [&f](Node *x) { f(*x->Package()); });
+        }
+
+        template<class F>
+        void reverse_for_each(F f) const {
+            Traverse(0, [&f](const Node *x) { f(static_cast<const value_type &>(*x->Package())); });
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef SJTU_STATIC_MAP_HPP
+#define SJTU_STATIC_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include "utility.hpp"
+#include "index_tree.hpp"
+
+namespace sjtu {
+    // red-black map that holds at most N elements and never allocates:
+    // the nodes are an array inside the object, laid out and linked like
+    // compact_map's slab (slot 0 is the black leaf, the color is the low
+    // bit of the parent link) with 16-bit indices when N allows; inserting
+    // into a full map throws runtime_error
+    template<
+            class Key,
+            class Value,
+            size_t N,
+            class Compare = std::less<Key>
+    > class static_map : public index_tree<Key, Value, Compare, index_array<pair<const Key, Value>, N>> {
+        typedef index_tree<Key, Value, Compare, index_array<pair<const Key, Value>, N>> Base;
+
+    public:
+        using Base::Base;
+
+        static constexpr size_t capacity() {
+            return N;
+        }
+
+        bool full() const {
+            return Base::n == N;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,501 @@
+#ifndef SJTU_STRING_MAP_HPP
+#define SJTU_STRING_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "node_pool.hpp"
+#include "rb_core.hpp"
+#include "rb_iterator.hpp"
+
+namespace sjtu {
+    // a map from text to Value that owns its keys: a key of up to INLINE
+    // bytes sits in the node, a longer one keeps its first INLINE bytes
+    // there and the whole of it in an append-only arena of the map, so an
+    // entry costs a slot in the node pool and no allocation of its own.
+    // Comparisons read the inline bytes first, the first eight of them as
+    // one integer, and reach the arena only on a tie. Keys are taken and
+    // handed out as std::string_view, a lookup never builds a
+    // std::string. Erased arena keys are repacked away once they make up
+    // half of the arena
+    template<
+            class Value,
+            class Allocator = std::allocator<Value>
+    > class string_map {
+    public:
+        static constexpr size_t INLINE = 16;
+
+    private:
+        class Node {
+        public:
+            Node *child[2];
+            Node *fa;
+            rb_color color;
+            uint32_t len;
+            char head[INLINE];
+            const char *tail; // the whole key, null when it fits in head
+            alignas(Value) unsigned char storage[sizeof(Value)];
+
+            Value *Package() {
+                return reinterpret_cast<Value *>(storage);
+            }
+
+            const Value *Package() const {
+                return reinterpret_cast<const Value *>(storage);
+            }
+
+            std::string_view Key() const {
+                return std::string_view(tail ? tail : head, len);
+            }
+        };
+
+        typedef node_pool<Node, Allocator> Pool;
+        typedef node_pool<char, Allocator> Arena;
+
+        template<class, class, class, class> friend class rb_iterator;
+
+        // the height of a red-black tree is at most 2 * log2(n + 1)
+        static const int MAX_DEPTH = 128;
+        static const size_t MIN_CHUNK = 4096;
+        static const size_t MAX_CHUNK = 1 << 20;
+
+        Pool pool;
+        Arena arena;
+        char *cursor, *limit;
+        size_t chunk;
+        size_t live, used; // bytes of arena keys still in the map, and ever
+        Node *root;
+        Node *verge;
+        size_t n;
+
+        Node *End() const {
+            return verge;
+        }
+
+        // eight bytes as a big-endian integer, so they order like memcmp
+        static uint64_t Load(const char *p) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            uint64_t v;
+            std::memcpy(&v, p, 8);
+            return __builtin_bswap64(v);
+#else
+            uint64_t v = 0;
+            for (int i = 0; i < 8; ++i)
+                v = v << 8 | (unsigned char)p[i];
+            return v;
+#endif
+        }
+
+        // the first eight bytes of key, zero padded like a node's head
+        static uint64_t Prefix(std::string_view key) {
+            char buf[8] = {};
+            std::memcpy(buf, key.data(), key.size() < 8 ? key.size() : 8);
+            return Load(buf);
+        }
+
+        // three-way, key (with prefix p) against the key of x; most steps
+        // end on the integer compare
+        static int Compare(std::string_view key, uint64_t p, const Node *x) {
+            uint64_t q = Load(x->head);
+            if (p != q)
+                return p < q ? -1 : 1;
+            size_t m = key.size() < x->len ? key.size() : x->len;
+            if (m > 8) {
+                size_t h = m < INLINE ? m : INLINE;
+                int c = std::memcmp(key.data() + 8, x->head + 8, h - 8);
+                if (!c && h < m)
+                    c = std::memcmp(key.data() + h, x->tail + h, m - h);
+                if (c)
+                    return c;
+            }
+            return key.size() < x->len ? -1 : key.size() > x->len;
+        }
+
+        // copies key to the arena
+        const char *Append(std::string_view key) {
+            if (size_t(limit - cursor) < key.size()) {
+                size_t size = key.size() > chunk ? key.size() : chunk;
+                cursor = arena.allocate_block(size);
+                limit = cursor + size;
+                if (chunk < MAX_CHUNK)
+                    chunk *= 2;
+            }
+            char *res = cursor;
+            std::memcpy(res, key.data(), key.size());
+            cursor += key.size();
+            live += key.size();
+            used += key.size();
+            return res;
+        }
+
+        void SetKey(Node *x, std::string_view key) {
+            if (key.size() > UINT32_MAX)
+                throw runtime_error();
+            x->len = (uint32_t)key.size();
+            std::memset(x->head, 0, INLINE);
+            std::memcpy(x->head, key.data(), key.size() < INLINE ? key.size() : INLINE);
+            x->tail = key.size() > INLINE ? Append(key) : nullptr;
+        }
+
+        Node *NewNode(std::string_view key, const Value &value) {
+            Node *x = pool.allocate(n);
+            try {
+                new (x->storage) Value(value);
+            }
+            catch (...) {
+                pool.deallocate(x);
+                throw;
+            }
+            try {
+                SetKey(x, key);
+            }
+            catch (...) {
+                x->Package()->~Value();
+                pool.deallocate(x);
+                throw;
+            }
+            x->color = RB_RED;
+            x->fa = x->child[0] = x->child[1] = nullptr;
+            return x;
+        }
+
+        void DeleteNode(Node *x) {
+            if (x->tail)
+                live -= x->len;
+            x->Package()->~Value();
+            pool.deallocate(x);
+        }
+
+        Node *Find(std::string_view key) const {
+            Node *x = root;
+            uint64_t p = Prefix(key);
+            while (x) {
+                int c = Compare(key, p, x);
+                if (!c)
+                    return x;
+                x = x->child[c < 0];
+            }
+            return verge;
+        }
+
+        // lower_bound / upper_bound on the three-way compare
+        Node *Bound(std::string_view key, bool upper) const {
+            Node *x = root, *res = verge;
+            uint64_t p = Prefix(key);
+            while (x) {
+                int c = Compare(key, p, x);
+                if (upper ? c < 0 : c <= 0) {
+                    res = x;
+                    x = x->child[1];
+                }
+                else
+                    x = x->child[0];
+            }
+            return res;
+        }
+
+        // like Find, but hangs a new node (copying a long key to the arena)
+        // where the search fell off; found tells which
+        Node *Insert(std::string_view key, const Value &value, bool &found) {
+            Node *x = root, *y = nullptr;
+            int c = 0;
+            uint64_t p = Prefix(key);
+            found = false;
+            while (x) {
+                c = Compare(key, p, x);
+                if (!c) {
+                    found = true;
+                    return x;
+                }
+                y = x;
+                x = x->child[c < 0];
+            }
+            x = NewNode(key, value);
+            x->fa = y;
+            if (y)
+                y->child[c < 0] = x;
+            else
+                root = x;
+            rb_insert_fixup(x, root);
+            ++n;
+            return x;
+        }
+
+        void Delete(Node *x) {
+            rb_erase(x, root);
+            DeleteNode(x);
+            --n;
+            if (used > 2 * live + MAX_CHUNK) {
+                try {
+                    Repack();
+                }
+                catch (...) {}
+            }
+        }
+
+        // copies the arena keys still in use into fresh blocks
+        void Repack() {
+            Arena fresh(arena.get_allocator());
+            arena.swap(fresh);
+            cursor = limit = nullptr;
+            chunk = MIN_CHUNK;
+            live = used = 0;
+            try {
+                Node *stack[MAX_DEPTH + 1];
+                int top = 0;
+                if (root)
+                    stack[top++] = root;
+                while (top) {
+                    Node *x = stack[--top];
+                    if (x->child[0])
+                        stack[top++] = x->child[0];
+                    if (x->child[1])
+                        stack[top++] = x->child[1];
+                    if (x->tail)
+                        x->tail = Append(std::string_view(x->tail, x->len));
+                }
+            }
+            catch (...) {
+                // the moved keys point into both sets of blocks now
+                arena.adopt(fresh);
+                throw;
+            }
+        }
+
+        void Destruct() {
+            if (root && !std::is_trivially_destructible<Value>::value) {
+                Node *stack[MAX_DEPTH + 1];
+                int top = 0;
+                stack[top++] = root;
+                while (top) {
+                    Node *x = stack[--top];
+                    if (x->child[0])
+                        stack[top++] = x->child[0];
+                    if (x->child[1])
+                        stack[top++] = x->child[1];
+                    x->Package()->~Value();
+                }
+            }
+            pool.release();
+            arena.release();
+            cursor = limit = nullptr;
+            chunk = MIN_CHUNK;
+            live = used = 0;
+            root = nullptr;
+            n = 0;
+        }
+
+        // same shape, the arena keys are packed in preorder
+        void Copy(const string_map &other) {
+            if (!other.root)
+                return;
+            pool.reserve(other.n);
+            const Node *src[MAX_DEPTH + 1];
+            Node *dst[MAX_DEPTH + 1];
+            int top = 0;
+            try {
+                root = NewNode(other.root->Key(), *other.root->Package());
+                root->color = other.root->color;
+                src[top] = other.root;
+                dst[top++] = root;
+                ++n;
+                while (top) {
+                    --top;
+                    const Node *s = src[top];
+                    Node *d = dst[top];
+                    for (int c = 0; c < 2; ++c)
+                        if (s->child[c]) {
+                            const Node *t = s->child[c];
+                            Node *e = NewNode(t->Key(), *t->Package());
+                            e->color = t->color;
+                            e->fa = d;
+                            d->child[c] = e;
+                            src[top] = t;
+                            dst[top++] = e;
+                            ++n;
+                        }
+                }
+            }
+            catch (...) {
+                Destruct();
+                throw;
+            }
+        }
+
+        void Initialize() {
+            cursor = limit = nullptr;
+            chunk = MIN_CHUNK;
+            live = used = 0;
+            root = nullptr;
+            n = 0;
+            verge = static_cast<Node *>(::operator new(sizeof(Node)));
+            verge->fa = verge->child[0] = verge->child[1] = nullptr;
+        }
+
+    public:
+        // key() and value() instead of a pair, the key has no std::string
+        // to refer to
+        class iterator : public rb_iterator<string_map, Node, Value, iterator> {
+        public:
+            using rb_iterator<string_map, Node, Value, iterator>::rb_iterator;
+
+            // valid until the entry is erased
+            std::string_view key() const {
+                return this->ptr->Key();
+            }
+
+            Value & value() const {
+                return *this->ptr->Package();
+            }
+        };
+        class const_iterator : public rb_iterator<string_map, const Node, const Value, const_iterator> {
+        public:
+            using rb_iterator<string_map, const Node, const Value, const_iterator>::rb_iterator;
+
+            std::string_view key() const {
+                return this->ptr->Key();
+            }
+
+            const Value & value() const {
+                return *this->ptr->Package();
+            }
+        };
+
+        string_map() {
+            Initialize();
+        }
+
+        explicit string_map(const Allocator &a):pool(typename Pool::allocator_type(a)),
+                arena(typename Arena::allocator_type(a)) {
+            Initialize();
+        }
+
+        string_map(const string_map &other):pool(std::allocator_traits<typename Pool::allocator_type>::
+                select_on_container_copy_construction(other.pool.get_allocator())),
+                arena(typename Arena::allocator_type(pool.get_allocator())) {
+            Initialize();
+            Copy(other);
+        }
+
+        string_map & operator=(const string_map &other) {
+            if (this == &other)
+                return *this;
+            Destruct();
+            Copy(other);
+            return *this;
+        }
+
+        ~string_map() {
+            Destruct();
+            ::operator delete(verge);
+        }
+
+        Value & at(std::string_view key) {
+            Node *x = Find(key);
+            if (x == verge)
+                throw index_out_of_bound();
+            return *x->Package();
+        }
+
+        const Value & at(std::string_view key) const {
+            Node *x = Find(key);
+            if (x == verge)
+                throw index_out_of_bound();
+            return *x->Package();
+        }
+
+        Value & operator[](std::string_view key) {
+            bool found;
+            return *Insert(key, Value(), found)->Package();
+        }
+
+        iterator begin() {
+            return iterator(root ? rb_extreme(root, 1) : verge, this);
+        }
+
+        const_iterator cbegin() const {
+            return const_iterator(root ? rb_extreme(root, 1) : verge, this);
+        }
+
+        iterator end() {
+            return iterator(verge, this);
+        }
+
+        const_iterator cend() const {
+            return const_iterator(verge, this);
+        }
+
+        bool empty() const {
+            return !n;
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        void clear() {
+            Destruct();
+        }
+
+        pair<iterator, bool> insert(std::string_view key, const Value &value) {
+            bool found;
+            Node *x = Insert(key, value, found);
+            return pair<iterator, bool>(iterator(x, this), !found);
+        }
+
+        void erase(iterator pos) {
+            if (pos.source != this || pos.ptr == verge)
+                throw invalid_iterator();
+            Delete(pos.ptr);
+        }
+
+        size_t erase(std::string_view key) {
+            Node *x = Find(key);
+            if (x == verge)
+                return 0;
+            Delete(x);
+            return 1;
+        }
+
+        size_t count(std::string_view key) const {
+            return Find(key) != verge;
+        }
+
+        iterator find(std::string_view key) {
+            return iterator(Find(key), this);
+        }
+
+        const_iterator find(std::string_view key) const {
+            return const_iterator(Find(key), this);
+        }
+
+        iterator lower_bound(std::string_view key) {
+            return iterator(Bound(key, false), this);
+        }
+
+        const_iterator lower_bound(std::string_view key) const {
+            return const_iterator(Bound(key, false), this);
+        }
+
+        iterator upper_bound(std::string_view key) {
+            return iterator(Bound(key, true), this);
+        }
+
+        const_iterator upper_bound(std::string_view key) const {
+            return const_iterator(Bound(key, true), this);
+        }
+
+        // bytes of arena handed out to keys, erased ones included
+        size_t arena_bytes() const {
+            return used;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,596 @@
+#ifndef SJTU_TOPDOWN_MAP_HPP
+#define SJTU_TOPDOWN_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "node_pool.hpp"
+
+namespace sjtu {
+    // red-black map whose nodes carry no parent pointer: insert and erase
+    // rebalance in a single pass down from a false root and iterators keep
+    // the path from the root instead of climbing fa
+    template<
+            class Key,
+            class Value,
+            class Compare = std::less<Key>,
+            class Allocator = std::allocator<pair<const Key, Value>>
+    > class topdown_map {
+    public:
+        typedef pair<const Key, Value> value_type;
+
+    private:
+        class Node {
+        public:
+            Node *child[2];
+            bool red;
+            alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+            value_type *Package() {
+                return reinterpret_cast<value_type *>(storage);
+            }
+
+            const value_type *Package() const {
+                return reinterpret_cast<const value_type *>(storage);
+            }
+        };
+
+        // the height is at most 2 * log2(n + 1), so a path of 64 nodes
+        // covers every size below 2^32
+        static const int MAX_DEPTH = 64;
+        static const size_t MAX_SIZE = ((size_t)1 << 32) - 1;
+
+        typedef node_pool<Node, Allocator> Pool;
+
+        Compare comp;
+        Pool pool;
+        Node *root;
+        size_t n;
+
+        static bool IsRed(const Node *x) {
+            return x && x->red;
+        }
+
+        // lifts x->child[!c] above x
+        static Node *Single(Node *x, int c) {
+            Node *y = x->child[!c];
+            x->child[!c] = y->child[c];
+            y->child[c] = x;
+            x->red = true;
+            y->red = false;
+            return y;
+        }
+
+        static Node *Double(Node *x, int c) {
+            x->child[!c] = Single(x->child[!c], !c);
+            return Single(x, c);
+        }
+
+        Node *NewNode(const Key &key, const Value &value) {
+            Node *x = new (pool.allocate(n)) Node;
+            try {
+                new (x->storage) value_type(key, value);
+            }
+            catch (...) {
+                pool.deallocate(x);
+                throw;
+            }
+            x->red = true;
+            x->child[0] = x->child[1] = nullptr;
+            return x;
+        }
+
+        void DeleteNode(Node *x) {
+            x->Package()->~value_type();
+            pool.deallocate(x);
+        }
+
+        // found tells whether key was already there, the node holding key
+        // is returned either way
+        Node *Insert(const Key &key, const Value &value, bool &found) {
+            found = false;
+            if (!root) {
+                root = NewNode(key, value);
+                root->red = false;
+                ++n;
+                return root;
+            }
+            Node head;
+            head.red = false;
+            head.child[0] = nullptr;
+            head.child[1] = root;
+            Node *t = &head, *g = nullptr, *p = nullptr, *q = root, *res = nullptr;
+            int c = 1, last = 1;
+            try {
+                while (true) {
+                    if (!q) {
+                        if (n == MAX_SIZE)
+                            throw runtime_error();
+                        p->child[c] = q = res = NewNode(key, value);
+                        ++n;
+                    }
+                    else if (IsRed(q->child[0]) && IsRed(q->child[1])) { // split a 4-node on the way down
+                        q->red = true;
+                        q->child[0]->red = false;
+                        q->child[1]->red = false;
+                    }
+                    if (IsRed(q) && IsRed(p)) {
+                        int c2 = t->child[1] == g;
+                        if (q == p->child[last])
+                            t->child[c2] = Single(g, !last);
+                        else
+                            t->child[c2] = Double(g, !last);
+                    }
+                    if (res)
+                        break;
+                    bool less = comp(key, q->Package()->first);
+                    if (!less && !comp(q->Package()->first, key)) {
+                        found = true;
+                        res = q;
+                        break;
+                    }
+                    last = c;
+                    c = less;
+                    if (g)
+                        t = g;
+                    g = p;
+                    p = q;
+                    q = q->child[c];
+                }
+            }
+            catch (...) {
+                root = head.child[1];
+                root->red = false;
+                throw;
+            }
+            root = head.child[1];
+            root->red = false;
+            return res;
+        }
+
+        // pushes a red node down the search path so the node finally cut
+        // off is red; the element is unlinked by putting its in-order
+        // neighbour q in its place, fp tracks the parent of the found node
+        // through the rotations
+        bool Erase(const Key &key) {
+            if (!root)
+                return false;
+            Node head;
+            head.red = false;
+            head.child[0] = nullptr;
+            head.child[1] = root;
+            Node *q = &head, *p = nullptr, *g = nullptr, *f = nullptr, *fp = nullptr;
+            int c = 1;
+            while (q->child[c]) {
+                int last = c;
+                g = p;
+                p = q;
+                q = q->child[c];
+                bool less = comp(key, q->Package()->first);
+                if (!less && !comp(q->Package()->first, key)) {
+                    f = q;
+                    fp = p;
+                }
+                c = less;
+                if (IsRed(q) || IsRed(q->child[c]))
+                    continue;
+                if (IsRed(q->child[!c])) {
+                    p = p->child[last] = Single(q, c);
+                    if (f == q)
+                        fp = p;
+                    continue;
+                }
+                Node *s = p->child[!last];
+                if (!s)
+                    continue;
+                if (!IsRed(s->child[!last]) && !IsRed(s->child[last])) { // color flip
+                    p->red = false;
+                    s->red = true;
+                    q->red = true;
+                }
+                else {
+                    int c2 = g->child[1] == p;
+                    if (IsRed(s->child[last]))
+                        g->child[c2] = Double(p, last);
+                    else
+                        g->child[c2] = Single(p, last);
+                    q->red = g->child[c2]->red = true;
+                    g->child[c2]->child[0]->red = false;
+                    g->child[c2]->child[1]->red = false;
+                    if (f == p)
+                        fp = g->child[c2];
+                }
+            }
+            if (f) {
+                p->child[p->child[1] == q] = q->child[q->child[0] == nullptr];
+                if (f != q) {
+                    q->child[0] = f->child[0];
+                    q->child[1] = f->child[1];
+                    q->red = f->red;
+                    fp->child[fp->child[1] == f] = q;
+                }
+                DeleteNode(f);
+                --n;
+            }
+            root = head.child[1];
+            if (root)
+                root->red = false;
+            return f != nullptr;
+        }
+
+        Node *Find(const Key &key) const {
+            Node *x = root;
+            while (x) {
+                bool less = comp(key, x->Package()->first);
+                if (!less && !comp(x->Package()->first, key))
+                    return x;
+                x = x->child[less];
+            }
+            return nullptr;
+        }
+
+        static Node *CloneNode(const Node *y, Node *x) {
+            new (x) Node;
+            new (x->storage) value_type(*y->Package());
+            x->red = y->red;
+            x->child[0] = x->child[1] = nullptr;
+            return x;
+        }
+
+        // preorder copy into one block, every node is linked as soon as it
+        // is built so a throwing copy leaves a well-formed tree behind
+        void Copy(const topdown_map &other) {
+            root = nullptr;
+            n = 0;
+            if (!other.root)
+                return;
+            Node *mem = pool.allocate_block(other.n);
+            const Node *src[MAX_DEPTH + 1];
+            Node *dst[MAX_DEPTH + 1];
+            int top = 0;
+            size_t k = 0;
+            try {
+                root = CloneNode(other.root, mem + k++);
+                src[top] = other.root;
+                dst[top++] = root;
+                while (top) {
+                    --top;
+                    const Node *s = src[top];
+                    Node *d = dst[top];
+                    for (int c = 0; c < 2; ++c)
+                        if (s->child[c]) {
+                            Node *e = CloneNode(s->child[c], mem + k++);
+                            d->child[c] = e;
+                            src[top] = s->child[c];
+                            dst[top++] = e;
+                        }
+                }
+            }
+            catch (...) {
+                Destruct();
+                throw;
+            }
+            n = other.n;
+        }
+
+        // rotates child[1] up until the top has none, then drops it,
+        // which needs neither recursion nor a stack
+        void Destruct() {
+            Node *rest = root;
+            while (rest) {
+                Node *x = rest, *y = x->child[1];
+                if (y) {
+                    x->child[1] = y->child[0];
+                    y->child[0] = x;
+                    rest = y;
+                }
+                else {
+                    rest = x->child[0];
+                    x->Package()->~value_type();
+                }
+            }
+            pool.release();
+            root = nullptr;
+            n = 0;
+        }
+
+        // the root-to-node path behind both iterator kinds, an empty path
+        // is end()
+        class Path {
+        public:
+            Node *node[MAX_DEPTH];
+            int depth;
+
+            Path():depth(0) {}
+
+            Node *Top() const {
+                return depth ? node[depth - 1] : nullptr;
+            }
+
+            void Descend(Node *x, int c) {
+                for (; x; x = x->child[c])
+                    node[depth++] = x;
+            }
+
+            // c = 1 steps to the next larger key, c = 0 to the next smaller
+            void Move(int c) {
+                Node *x = node[depth - 1];
+                if (x->child[!c]) {
+                    Descend(x->child[!c], c);
+                    return;
+                }
+                while (true) {
+                    Node *y = node[--depth];
+                    if (!depth || node[depth - 1]->child[c] == y)
+                        break;
+                }
+            }
+        };
+
+        Path Locate(const Key &key) const {
+            Path res;
+            Node *x = root;
+            while (x) {
+                res.node[res.depth++] = x;
+                bool less = comp(key, x->Package()->first);
+                if (!less && !comp(x->Package()->first, key))
+                    return res;
+                x = x->child[less];
+            }
+            res.depth = 0;
+            return res;
+        }
+
+    public:
+        class const_iterator;
+        class iterator {
+        private:
+            Path path;
+            const topdown_map *source;
+
+            friend topdown_map;
+
+            iterator(const Path &path, const topdown_map *source):path(path), source(source) {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = Value;
+            using pointer = Value*;
+            using reference = Value&;
+            using iterator_category = std::output_iterator_tag;
+            using iterator_assignable = my_true_type;
+
+            iterator():source(nullptr) {}
+
+            iterator operator++(int) {
+                iterator res = *this;
+                operator++();
+                return res;
+            }
+
+            iterator & operator++() {
+                if (!path.depth)
+                    throw invalid_iterator();
+                path.Move(1);
+                return *this;
+            }
+
+            iterator operator--(int) {
+                iterator res = *this;
+                operator--();
+                return res;
+            }
+
+            iterator & operator--() {
+                if (!path.depth)
+                    path.Descend(source->root, 0);
+                else
+                    path.Move(0);
+                if (!path.depth)
+                    throw invalid_iterator();
+                return *this;
+            }
+
+            topdown_map::value_type & operator*() const {
+                return *path.Top()->Package();
+            }
+
+            topdown_map::value_type* operator->() const noexcept {
+                return path.Top()->Package();
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return path.Top() == rhs.path.Top();
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return path.Top() == rhs.path.Top();
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return !(*this == rhs);
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return !(*this == rhs);
+            }
+        };
+        class const_iterator {
+        private:
+            Path path;
+            const topdown_map *source;
+
+            friend topdown_map;
+
+            const_iterator(const Path &path, const topdown_map *source):path(path), source(source) {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = Value;
+            using pointer = Value*;
+            using reference = Value&;
+            using iterator_category = std::output_iterator_tag;
+            using iterator_assignable = my_false_type;
+
+            const_iterator():source(nullptr) {}
+
+            const_iterator(const iterator &other):path(other.path), source(other.source) {}
+
+            const_iterator operator++(int) {
+                const_iterator res = *this;
+                operator++();
+                return res;
+            }
+
+            const_iterator & operator++() {
+                if (!path.depth)
+                    throw invalid_iterator();
+                path.Move(1);
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator res = *this;
+                operator--();
+                return res;
+            }
+
+            const_iterator & operator--() {
+                if (!path.depth)
+                    path.Descend(source->root, 0);
+                else
+                    path.Move(0);
+                if (!path.depth)
+                    throw invalid_iterator();
+                return *this;
+            }
+
+            const topdown_map::value_type & operator*() const {
+                return *path.Top()->Package();
+            }
+
+            const topdown_map::value_type* operator->() const noexcept {
+                return path.Top()->Package();
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return path.Top() == rhs.path.Top();
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return path.Top() == rhs.path.Top();
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return !(*this == rhs);
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return !(*this == rhs);
+            }
+        };
+
+        topdown_map():root(nullptr), n(0) {}
+
+        topdown_map(const topdown_map &other):comp(other.comp), root(nullptr), n(0) {
+            Copy(other);
+        }
+
+        topdown_map & operator=(const topdown_map &other) {
+            if (this == &other)
+                return *this;
+            Destruct();
+            Copy(other);
+            return *this;
+        }
+
+        ~topdown_map() {
+            Destruct();
+        }
+
+        Value & at(const Key &key) {
+            Node *x = Find(key);
+            if (!x)
+                throw index_out_of_bound();
+            return x->Package()->second;
+        }
+
+        const Value & at(const Key &key) const {
+            Node *x = Find(key);
+            if (!x)
+                throw index_out_of_bound();
+            return x->Package()->second;
+        }
+
+        Value & operator[](const Key &key) {
+            bool found;
+            return Insert(key, Value(), found)->Package()->second;
+        }
+
+        const Value & operator[](const Key &key) const {
+            return at(key);
+        }
+
+        iterator begin() {
+            Path path;
+            path.Descend(root, 1);
+            return iterator(path, this);
+        }
+
+        const_iterator cbegin() const {
+            Path path;
+            path.Descend(root, 1);
+            return const_iterator(path, this);
+        }
+
+        iterator end() {
+            return iterator(Path(), this);
+        }
+
+        const_iterator cend() const {
+            return const_iterator(Path(), this);
+        }
+
+        bool empty() const {
+            return !n;
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        void clear() {
+            Destruct();
+        }
+
+        pair<iterator, bool> insert(const value_type &value) {
+            bool found;
+            Insert(value.first, value.second, found);
+            return pair<iterator, bool>(iterator(Locate(value.first), this), !found);
+        }
+
+        void erase(iterator pos) {
+            if (pos.source != this || !pos.path.depth)
+                throw invalid_iterator();
+            Erase(pos->first);
+        }
+
+        size_t count(const Key &key) const {
+            return Find(key) != nullptr;
+        }
+
+        iterator find(const Key &key) {
+            return iterator(Locate(key), this);
+        }
+
+        const_iterator find(const Key &key) const {
+            return const_iterator(Locate(key), this);
+        }
+    };
+}
+
+#endif
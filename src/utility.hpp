@@ -5,6 +5,9 @@
 
 namespace sjtu {
 
+struct my_true_type {};
+struct my_false_type {};
+
 template<class T1, class T2>
 class pair {
 public:
@@ -13,13 +16,13 @@ public:
 	constexpr pair() : first(), second() {}
 	pair(const pair &other) = default;
 	pair(pair &&other) = default;
-	pair(const T1 &x, const T2 &y) : first(x), second(y) {}
+	constexpr pair(const T1 &x, const T2 &y) : first(x), second(y) {}
 	template<class U1, class U2>
-	pair(U1 &&x, U2 &&y) : first(x), second(y) {}
+	constexpr pair(U1 &&x, U2 &&y) : first(x), second(y) {}
 	template<class U1, class U2>
-	pair(const pair<U1, U2> &other) : first(other.first), second(other.second) {}
+	constexpr pair(const pair<U1, U2> &other) : first(other.first), second(other.second) {}
 	template<class U1, class U2>
-	pair(pair<U1, U2> &&other) : first(other.first), second(other.second) {}
+	constexpr pair(pair<U1, U2> &&other) : first(other.first), second(other.second) {}
 };
 
 }
@@ -1,4 +1,5 @@
 import os
+import glob
 
 name_list = ['one', 'two', 'three', 'four', 'five']
 for i in range(5):
@@ -6,9 +7,9 @@ for i in range(5):
 name_str = ""
 for name in name_list:
     name_str += " data/{name}".format(name=name)
-os.system("echo" + name_str + " | xargs -n 1 cp -v src/map.hpp")
-os.system("echo" + name_str + " | xargs -n 1 cp -v src/exceptions.hpp")
-os.system("echo" + name_str + " | xargs -n 1 cp -v src/utility.hpp")
+headers = [os.path.basename(path) for path in glob.glob("src/*.hpp")]
+for header in headers:
+    os.system("echo" + name_str + " | xargs -n 1 cp -v src/{header}".format(header=header))
 
 for name in name_list:
     os.system("g++ data/{name}/code.cpp -o code 1> log/log-{name}-1.txt 2> log/log-{name}-2.txt".format(name=name))
@@ -20,9 +21,8 @@ for name in name_list:
     print("finish check {name}".format(name=name))
 
 for name in name_list:
-    os.system("rm data/{name}/map.hpp".format(name=name))
-    os.system("rm data/{name}/exceptions.hpp".format(name=name))
-    os.system("rm data/{name}/utility.hpp".format(name=name))
+    for header in headers:
+        os.system("rm data/{name}/{header}".format(name=name, header=header))
     os.system("rm data/{name}/answer.out".format(name=name))
 
 os.system("rm code")
@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/art_map.hpp"
+
+using namespace std;
+
+vector<unsigned long long> A;
+vector<string> S;
+
+unsigned long long Random() {
+    return (unsigned long long)rand() << 40 ^ (unsigned long long)rand() << 20 ^ rand();
+}
+
+unsigned long long Miss(unsigned long long key) {
+    return key + 1;
+}
+
+// a different key of the same shape
+string Miss(string key) {
+    key.back() ^= 1;
+    return key;
+}
+
+template<class Map, class Key>
+void run(const char *name, const vector<Key> &keys) {
+    clock_t start_time = clock();
+    Map test;
+    for (size_t i = 0; i < keys.size(); ++i)
+        test[keys[i]] = i;
+    clock_t mid_time = clock();
+    long long s = 0;
+    for (int round = 0; round < 4; ++round)
+        for (size_t i = 0; i < keys.size(); ++i)
+            s += test.count(i & 1 ? Miss(keys[i]) : keys[i]);
+    clock_t end_time = clock();
+    for (auto it = test.cbegin(); it != test.cend(); ++it)
+        s += it->second;
+    cout << name << ": insert " << 1.0 * (mid_time - start_time) / CLOCKS_PER_SEC
+         << ", lookup " << 1.0 * (end_time - mid_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+}
+
+// usage: art_speedtest [count] [dense]; the string keys look like paths
+// under a few long shared directories
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+    bool dense = argc > 2 && argv[2][0] == '1';
+    const char *dirs[] = {"/srv/data/shared/", "/srv/data/shared/archive/2024/", "/home/user/"};
+    for (size_t i = 0; i < count; ++i) {
+        A.push_back(dense ? Random() % (2 * count) : Random());
+        S.push_back(dirs[i % 3] + to_string(A[i] % (8 * count)) + ".log");
+    }
+    run<sjtu::map<unsigned long long, int>>("map", A);
+    run<sjtu::art_map<unsigned long long, int>>("art_map", A);
+    run<sjtu::map<string, int>>("map<string>", S);
+    run<sjtu::art_map<string, int>>("art_map<string>", S);
+}
@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/bimap.hpp"
+
+using namespace std;
+
+// a leaderboard: scores of ids change at random and the top of the board
+// is read back; map<Id, Key> with a map<Key, Id> kept in sync by hand,
+// where Key = Score << 32 | update number so equal scores are ordered by
+// when they were set, as bimap orders them, against one bimap. Both must
+// read back the same boards
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t updates = 4 * count;
+    vector<int> id, score;
+    for (size_t i = 0; i < updates; ++i) {
+        id.push_back(rand() % count);
+        score.push_back(rand() % (count / 4));
+    }
+
+    clock_t start_time = clock();
+    long long s = 0;
+    {
+        sjtu::map<int, long long> by_id;
+        sjtu::map<long long, int> by_score;
+        for (size_t i = 0; i < updates; ++i) {
+            long long key = (long long)score[i] << 32 | (long long)i;
+            sjtu::map<int, long long>::iterator it = by_id.find(id[i]);
+            if (it != by_id.end()) {
+                by_score.erase(by_score.find(it->second));
+                it->second = key;
+            }
+            else
+                by_id[id[i]] = key;
+            by_score[key] = id[i];
+            if (i % 64 == 0) {
+                sjtu::map<long long, int>::const_iterator top = by_score.cbegin();
+                for (int k = 0; k < 10 && top != by_score.cend(); ++k, ++top)
+                    s += top->second;
+            }
+        }
+    }
+    clock_t end_time = clock();
+    cout << "two maps: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+    long long expect = s;
+
+    start_time = clock();
+    s = 0;
+    {
+        sjtu::bimap<int, int> board;
+        for (size_t i = 0; i < updates; ++i) {
+            board.insert_or_assign(id[i], score[i]);
+            if (i % 64 == 0) {
+                sjtu::bimap<int, int>::value_iterator top = board.value_begin();
+                for (int k = 0; k < 10 && top != board.value_end(); ++k, ++top)
+                    s += top->first;
+            }
+        }
+    }
+    end_time = clock();
+    cout << "bimap: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+    if (s != expect) {
+        cout << "bimap read back different boards" << endl;
+        return 1;
+    }
+    return 0;
+}
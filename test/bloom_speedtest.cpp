@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/bloom_filter.hpp"
+
+using namespace std;
+
+// lookups that mostly miss, on long keys sharing a prefix so every
+// comparison walks it: map as is, against the same map with its Bloom
+// filter on; the false positive rate is measured on the absent keys
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 500000;
+    size_t lookups = 8 * count;
+    string prefix(48, 'k');
+    vector<string> key, probe;
+    for (size_t i = 0; i < count; ++i)
+        key.push_back(prefix + to_string(2LL * rand()));
+    // one in ten probes is a stored key, the rest are odd and so absent
+    for (size_t i = 0; i < lookups; ++i)
+        probe.push_back(i % 10 ? prefix + to_string(2LL * rand() + 1) : key[rand() % count]);
+
+    sjtu::map<string, int> m;
+    for (size_t i = 0; i < count; ++i)
+        m[key[i]] = i;
+
+    clock_t start_time = clock();
+    long long s = 0;
+    for (size_t i = 0; i < lookups; ++i)
+        s += m.count(probe[i]);
+    clock_t end_time = clock();
+    cout << "map: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+
+    m.enable_bloom_filter();
+    start_time = clock();
+    s = 0;
+    for (size_t i = 0; i < lookups; ++i)
+        s += m.count(probe[i]);
+    end_time = clock();
+    cout << "map with bloom filter: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+
+    sjtu::bloom_filter<string> f(std::hash<string>(), 16, 2 * count + 64);
+    for (size_t i = 0; i < count; ++i)
+        f.insert(key[i]);
+    size_t absent = 0, passed = 0;
+    for (size_t i = 0; i < lookups; ++i)
+        if (i % 10) {
+            ++absent;
+            passed += f.might_contain(probe[i]);
+        }
+    cout << "false positive rate: " << 1.0 * passed / absent << " measured, "
+         << m.bloom_false_positive_rate() << " estimated, " << f.memory_bytes() << " bytes" << endl;
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <ctime>
+#include <future>
+#include "../src/map.hpp"
+
+using namespace std;
+
+sjtu::map<int, string> test;
+
+void build() {
+    for (int i = 0; i < 1000000; ++i)
+        test[rand()] = string(32, 'a' + i % 26);
+}
+
+int main() {
+    build();
+    clock_t start_time = clock();
+    test.clear();
+    cout << "clear: " << 1.0 * (clock() - start_time) / CLOCKS_PER_SEC << endl;
+
+    build();
+    start_time = clock();
+    test.clear_deferred();
+    cout << "clear_deferred: " << 1.0 * (clock() - start_time) / CLOCKS_PER_SEC << endl;
+    double worst = 0;
+    int slices = 0;
+    for (bool done = false; !done; ++slices) {
+        clock_t slice_time = clock();
+        done = test.reclaim(10000);
+        double t = 1.0 * (clock() - slice_time) / CLOCKS_PER_SEC;
+        worst = t > worst ? t : worst;
+    }
+    cout << "reclaim: " << slices << " slices, worst " << worst << endl;
+
+    build();
+    std::promise<void> gone;
+    std::future<void> teardown = gone.get_future();
+    start_time = clock();
+    test.clear_async([&gone]() { gone.set_value(); });
+    cout << "clear_async: " << 1.0 * (clock() - start_time) / CLOCKS_PER_SEC << endl;
+    // the background teardown has to finish before main returns
+    teardown.wait();
+    cout << "clear_async teardown: " << 1.0 * (clock() - start_time) / CLOCKS_PER_SEC << endl;
+}
@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/compact_map.hpp"
+
+using namespace std;
+
+vector<int> A;
+
+long resident() {
+    long pages = 0, rss = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%ld %ld", &pages, &rss) != 2)
+            rss = 0;
+        fclose(f);
+    }
+    return rss * 4096;
+}
+
+template<class Map>
+void run(const char *name) {
+    long before = resident();
+    clock_t start_time = clock();
+    Map *test = new Map;
+    for (size_t i = 0; i < A.size(); ++i)
+        (*test)[A[i]] = i;
+    clock_t insert_time = clock();
+    long bytes = resident() - before;
+    long long s = 0;
+    for (int t = 0; t < 3; ++t)
+        for (size_t i = 0; i < A.size(); ++i)
+            s += test->count(A[i] ^ t);
+    clock_t find_time = clock();
+    delete test;
+    cout << name << ": insert " << 1.0 * (insert_time - start_time) / CLOCKS_PER_SEC
+         << " lookup " << 1.0 * (find_time - insert_time) / CLOCKS_PER_SEC
+         << " bytes/entry " << 1.0 * bytes / A.size() << " (" << s << ")" << endl;
+}
+
+// usage: compact_speedtest [entries]
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    for (size_t i = 0; i < n; ++i)
+        A.push_back(rand());
+    run<sjtu::compact_map<int, int>>("compact_map");
+    run<sjtu::map<int, int>>("map");
+}
@@ -0,0 +1,87 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include "../src/map.hpp"
+#include "../src/set.hpp"
+
+using namespace std;
+
+// erasing a root that has one child used to leave the child's fa on the
+// erased node; the next insert reused that node from the pool and the
+// tree got a cycle, so walking it never reached end(). Every walk here is
+// capped at size() + 1 steps
+template<class Tree, class Put, class Erase>
+bool check(const char *name, Put put, Erase erase) {
+    Tree t;
+    put(t, 1);
+    put(t, 2);
+    erase(t, 1);
+    put(t, 3);
+    int expect[] = {2, 3}, k = 0;
+    for (auto it = t.begin(); it != t.end() && k < 3; ++it, ++k)
+        if (k >= 2 || *it != expect[k]) {
+            cout << name << ": wrong order after erasing the root" << endl;
+            return false;
+        }
+    if (k != 2) {
+        cout << name << ": " << k << " elements instead of 2" << endl;
+        return false;
+    }
+
+    Tree u;
+    std::set<int> ref;
+    for (int i = 0; i < 200000; ++i) {
+        int key = rand() % 16;
+        if (rand() % 2) {
+            put(u, key);
+            ref.insert(key);
+        }
+        else if (ref.count(key)) {
+            erase(u, key);
+            ref.erase(key);
+        }
+        size_t steps = 0;
+        auto r = ref.begin();
+        for (auto it = u.begin(); it != u.end(); ++it, ++r)
+            if (++steps > ref.size() || *it != *r) {
+                cout << name << ": walk went wrong after " << i << " operations" << endl;
+                return false;
+            }
+        if (steps != ref.size()) {
+            cout << name << ": walk ended early after " << i << " operations" << endl;
+            return false;
+        }
+    }
+    cout << name << ": ok" << endl;
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok &= check<sjtu::set<int>>("set",
+            [](sjtu::set<int> &t, int key) { t.insert(key); },
+            [](sjtu::set<int> &t, int key) { t.erase(key); });
+    // map's iterator dereferences to the pair, compare the keys through a view
+    struct keys : sjtu::map<int, int> {
+        struct iterator : sjtu::map<int, int>::iterator {
+            iterator(const sjtu::map<int, int>::iterator &it):sjtu::map<int, int>::iterator(it) {}
+
+            int operator*() const {
+                return (*this)->first;
+            }
+        };
+
+        iterator begin() {
+            return sjtu::map<int, int>::begin();
+        }
+
+        iterator end() {
+            return sjtu::map<int, int>::end();
+        }
+    };
+    ok &= check<keys>("map",
+            [](keys &t, int key) { t[key] = key; },
+            [](keys &t, int key) { t.erase(t.find(key)); });
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <ctime>
+#include "../src/map.hpp"
+
+using namespace std;
+
+sjtu::map<int, int> test;
+long long s1, s2;
+
+int main() {
+    for (int i = 0; i < 1000000; ++i) {
+        int a = rand(), b = rand() % 1000;
+        test[a] = b;
+    }
+    clock_t start_time = clock();
+    for (int t = 0; t < 10; ++t)
+        for (sjtu::map<int, int>::iterator it = test.begin(); it != test.end(); ++it)
+            s1 += it->second;
+    clock_t mid_time = clock();
+    for (int t = 0; t < 10; ++t)
+        test.for_each([](const sjtu::pair<const int, int> &x) { s2 += x.second; });
+    clock_t end_time = clock();
+    cout << (s1 == s2) << endl;
+    cout << "iterator: " << 1.0 * (mid_time - start_time) / CLOCKS_PER_SEC << endl;
+    cout << "for_each: " << 1.0 * (end_time - mid_time) / CLOCKS_PER_SEC << endl;
+}
@@ -0,0 +1,55 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/frozen_map.hpp"
+
+using namespace std;
+
+const int SIZE = 4096;
+
+// the table is generated, sorted and checked by the compiler (C++17 for
+// the constexpr lambda), nothing runs at startup
+constexpr auto table = [] {
+    int k[SIZE] = {}, v[SIZE] = {};
+    for (int i = 0; i < SIZE; ++i) {
+        k[i] = (int)((i * 2654435761u) % 1000003);
+        v[i] = i;
+    }
+    return sjtu::frozen_map<int, int, SIZE>(k, v);
+}();
+
+static_assert(table.at((int)((7 * 2654435761u) % 1000003)) == 7, "table is built at compile time");
+
+vector<int> A;
+
+// usage: frozen_speedtest [lookups]
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+    for (size_t i = 0; i < n; ++i)
+        A.push_back(i % 2 ? (int)((rand() % SIZE * 2654435761u) % 1000003) : rand() % 1000003);
+    clock_t start_time = clock();
+    sjtu::map<int, int> test;
+    for (int i = 0; i < SIZE; ++i)
+        test[(int)((i * 2654435761u) % 1000003)] = i;
+    sjtu::column_snapshot<int, int> snap = test.snapshot();
+    clock_t build_time = clock();
+    long long s1 = 0, s2 = 0, s3 = 0;
+    for (size_t i = 0; i < n; ++i)
+        s1 += test.count(A[i]);
+    clock_t map_time = clock();
+    for (size_t i = 0; i < n; ++i)
+        s2 += snap.find(A[i]) != snap.size();
+    clock_t snap_time = clock();
+    for (size_t i = 0; i < n; ++i)
+        s3 += table.count(A[i]);
+    clock_t frozen_time = clock();
+    cout << (s1 == s2 && s2 == s3) << endl;
+    cout << "map build + snapshot: " << 1.0 * (build_time - start_time) / CLOCKS_PER_SEC << endl;
+    cout << "map: " << 1.0 * (map_time - build_time) / CLOCKS_PER_SEC << endl;
+    cout << "column_snapshot: " << 1.0 * (snap_time - map_time) / CLOCKS_PER_SEC << endl;
+    cout << "frozen_map: " << 1.0 * (frozen_time - snap_time) / CLOCKS_PER_SEC << endl;
+}
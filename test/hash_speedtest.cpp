@@ -0,0 +1,41 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+
+using namespace std;
+
+vector<long long> A;
+
+// usage: hash_speedtest [entries]
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    sjtu::map<long long, int> test;
+    for (size_t i = 0; i < n; ++i) {
+        long long a = (long long)rand() << 31 | rand();
+        test[a] = i;
+        A.push_back(i % 2 ? a : a + 1);
+    }
+    for (size_t i = A.size(); i > 1; --i)
+        swap(A[i - 1], A[rand() % i]);
+    clock_t start_time = clock();
+    sjtu::hash_snapshot<long long, int> frozen = test.freeze_hash();
+    clock_t build_time = clock();
+    long long s1 = 0, s2 = 0;
+    for (int t = 0; t < 3; ++t)
+        for (size_t i = 0; i < A.size(); ++i)
+            s1 += test.find(A[i]) != test.end();
+    clock_t map_time = clock();
+    for (int t = 0; t < 3; ++t)
+        for (size_t i = 0; i < A.size(); ++i)
+            s2 += frozen.count(A[i]);
+    clock_t hash_time = clock();
+    cout << (s1 == s2) << endl;
+    cout << "freeze_hash build: " << 1.0 * (build_time - start_time) / CLOCKS_PER_SEC << endl;
+    cout << "map::find: " << 1.0 * (map_time - build_time) / CLOCKS_PER_SEC << endl;
+    cout << "hash_snapshot: " << 1.0 * (hash_time - map_time) / CLOCKS_PER_SEC << endl;
+    cout << "bits per key: " << frozen.bits_per_key() << endl;
+}
@@ -0,0 +1,68 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/int_set.hpp"
+
+using namespace std;
+
+// the map<int, int>-as-a-set pattern of test/set.cpp against int_set on a
+// dense key range: build, then membership tests, then an in-order scan
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    size_t big = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000000;
+    vector<int> A;
+    for (size_t i = 0; i < count; ++i)
+        A.push_back(rand() % (2 * count));
+
+    clock_t start_time = clock();
+    sjtu::map<int, int> m;
+    for (size_t i = 0; i < count; ++i)
+        m[A[i]] = 0;
+    clock_t mid_time = clock();
+    long long s = 0;
+    for (size_t i = 0; i < count; ++i)
+        s += m.count(A[i] + (i & 1));
+    clock_t end_time = clock();
+    cout << "map: insert " << 1.0 * (mid_time - start_time) / CLOCKS_PER_SEC
+         << ", count " << 1.0 * (end_time - mid_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+    m.clear();
+
+    start_time = clock();
+    sjtu::int_set t;
+    for (size_t i = 0; i < count; ++i)
+        t.insert(A[i]);
+    mid_time = clock();
+    s = 0;
+    for (size_t i = 0; i < count; ++i)
+        s += t.count(A[i] + (i & 1));
+    end_time = clock();
+    cout << "int_set: insert " << 1.0 * (mid_time - start_time) / CLOCKS_PER_SEC
+         << ", count " << 1.0 * (end_time - mid_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+
+    // every other value of [0, 2 * big) in random order, then every value
+    // below big / 2 as runs
+    sjtu::int_set d;
+    start_time = clock();
+    for (size_t i = 0; i < big; ++i)
+        d.insert((int)(((unsigned long long)i * 2654435761u % big) * 2));
+    for (size_t i = 0; i < big / 2; ++i)
+        d.insert((int)i);
+    d.optimize();
+    end_time = clock();
+    cout << "int_set dense: " << d.size() << " values, build " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC
+         << ", " << 1.0 * d.memory_bytes() / d.size() << " bytes per value" << endl;
+    start_time = clock();
+    s = 0;
+    for (sjtu::int_set::const_iterator it = d.cbegin(); it != d.cend(); ++it)
+        s += *it & 1;
+    s += d.rank((int)big) + d.select(d.size() / 2);
+    end_time = clock();
+    cout << "int_set dense scan: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+    sjtu::int_set e = d & t;
+    e |= t;
+    cout << "int_set and/or: " << e.size() << endl;
+}
@@ -0,0 +1,60 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/interval_map.hpp"
+
+using namespace std;
+
+// stabbing and short range queries over random intervals: a map keyed by
+// lo << 32 | id walked from begin() until lo passes the query, against the
+// interval_map visitors
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 200000;
+    size_t queries = 2000;
+    int range = 1 << 30;
+    vector<int> lo, hi, qlo, qhi;
+    for (size_t i = 0; i < count; ++i) {
+        lo.push_back(rand() % range);
+        hi.push_back(lo.back() + rand() % (range / (int)count * 64));
+    }
+    for (size_t i = 0; i < queries; ++i) {
+        qlo.push_back(rand() % range);
+        qhi.push_back(i % 2 ? qlo.back() : qlo.back() + rand() % (range / (int)count * 16));
+    }
+
+    clock_t start_time = clock();
+    long long s = 0;
+    {
+        sjtu::map<long long, int> m;
+        for (size_t i = 0; i < count; ++i)
+            m[(long long)lo[i] << 32 | i] = hi[i];
+        for (size_t i = 0; i < queries; ++i)
+            for (sjtu::map<long long, int>::const_iterator it = m.cbegin();
+                 it != m.cend() && (it->first >> 32) <= qhi[i]; ++it)
+                if (it->second >= qlo[i])
+                    s += it->first & 0xffffffff;
+    }
+    clock_t end_time = clock();
+    cout << "map scan: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+
+    start_time = clock();
+    s = 0;
+    {
+        sjtu::interval_map<int, int> m;
+        for (size_t i = 0; i < count; ++i)
+            m.insert(lo[i], hi[i], i);
+        for (size_t i = 0; i < queries; ++i) {
+            if (i % 2)
+                m.stabbing(qlo[i], [&s](const sjtu::interval<int, int> &x) { s += x.value; });
+            else
+                m.overlapping(qlo[i], qhi[i], [&s](const sjtu::interval<int, int> &x) { s += x.value; });
+        }
+    }
+    end_time = clock();
+    cout << "interval_map: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+    return 0;
+}
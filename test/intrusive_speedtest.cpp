@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/intrusive_tree.hpp"
+
+using namespace std;
+
+struct by_id;
+
+// objects that already live in a pool of our own
+struct Order : sjtu::rb_hook<by_id> {
+    int id;
+    char payload[40];
+};
+
+struct IdOf {
+    const int &operator()(const Order &o) const {
+        return o.id;
+    }
+};
+
+// index the pool by id, then churn: erase and re-insert, and look up
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    vector<Order> orders(count);
+    for (size_t i = 0; i < count; ++i)
+        orders[i].id = rand();
+
+    clock_t start_time = clock();
+    long long s = 0;
+    {
+        sjtu::map<int, Order *> test;
+        for (size_t i = 0; i < count; ++i)
+            test[orders[i].id] = &orders[i];
+        for (int round = 0; round < 2; ++round)
+            for (size_t i = 0; i < count; ++i) {
+                sjtu::map<int, Order *>::iterator it = test.find(orders[i].id);
+                if (it != test.end() && it->second == &orders[i]) {
+                    test.erase(it);
+                    test[orders[i].id] = &orders[i];
+                }
+                s += test.count(orders[(i * 7) % count].id);
+            }
+    }
+    clock_t end_time = clock();
+    cout << "map<int, Order *>: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+
+    start_time = clock();
+    s = 0;
+    {
+        sjtu::intrusive_tree<Order, int, IdOf, std::less<int>, by_id> test;
+        for (size_t i = 0; i < count; ++i)
+            test.insert(orders[i]);
+        for (int round = 0; round < 2; ++round)
+            for (size_t i = 0; i < count; ++i) {
+                sjtu::intrusive_tree<Order, int, IdOf, std::less<int>, by_id>::iterator it = test.find(orders[i].id);
+                if (it != test.end() && &*it == &orders[i]) {
+                    test.erase(it);
+                    test.insert(orders[i]);
+                }
+                s += test.count(orders[(i * 7) % count].id);
+            }
+    }
+    end_time = clock();
+    cout << "intrusive_tree<Order>: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+}
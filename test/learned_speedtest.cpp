@@ -0,0 +1,73 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+
+using namespace std;
+
+vector<uint64_t> A, eytzinger;
+
+// the runtime form of frozen_map's layout: node k has children 2k, 2k + 1
+void Lay(const uint64_t *k, size_t n, size_t x, size_t &i) {
+    if (x > n)
+        return;
+    Lay(k, n, 2 * x, i);
+    eytzinger[x] = k[i++];
+    Lay(k, n, 2 * x + 1, i);
+}
+
+bool EytzingerCount(uint64_t key) {
+    size_t n = eytzinger.size() - 1, x = 1;
+    while (x <= n)
+        x = 2 * x + (eytzinger[x] < key);
+    x >>= __builtin_ctzll(~x) + 1;
+    return x && eytzinger[x] == key;
+}
+
+// usage: learned_speedtest [entries]
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+    sjtu::map<uint64_t, int> test;
+    // close to evenly spread keys, with jitter
+    for (size_t i = 0; i < n; ++i)
+        test[i * 1000 + rand() % 1000] = i;
+    for (size_t i = 0; i < n; ++i)
+        A.push_back((uint64_t)(rand() % n) * 1000 + rand() % 1000);
+    clock_t start_time = clock();
+    sjtu::column_snapshot<uint64_t, int> snap = test.snapshot();
+    clock_t snap_time = clock();
+    eytzinger.resize(n + 1);
+    size_t k = 0;
+    Lay(snap.keys(), n, 1, k);
+    clock_t eytzinger_time = clock();
+    sjtu::learned_snapshot<uint64_t, int> learned = test.freeze_learned(32);
+    clock_t learned_time = clock();
+    long long s[4] = {0, 0, 0, 0};
+    clock_t t[5];
+    t[0] = clock();
+    for (size_t i = 0; i < n; ++i)
+        s[0] += test.find(A[i]) != test.end();
+    t[1] = clock();
+    for (size_t i = 0; i < n; ++i)
+        s[1] += snap.find(A[i]) != snap.size();
+    t[2] = clock();
+    for (size_t i = 0; i < n; ++i)
+        s[2] += EytzingerCount(A[i]);
+    t[3] = clock();
+    for (size_t i = 0; i < n; ++i)
+        s[3] += learned.count(A[i]);
+    t[4] = clock();
+    cout << (s[0] == s[1] && s[1] == s[2] && s[2] == s[3]) << endl;
+    cout << "build: snapshot " << 1.0 * (snap_time - start_time) / CLOCKS_PER_SEC
+         << " eytzinger " << 1.0 * (eytzinger_time - snap_time) / CLOCKS_PER_SEC
+         << " learned " << 1.0 * (learned_time - eytzinger_time) / CLOCKS_PER_SEC << endl;
+    const char *name[] = {"map::find", "binary search", "eytzinger", "learned"};
+    for (int i = 0; i < 4; ++i)
+        cout << name[i] << ": " << 1.0 * (t[i + 1] - t[i]) / CLOCKS_PER_SEC << endl;
+    cout << "index bytes: eytzinger " << eytzinger.size() * sizeof(uint64_t)
+         << " learned " << learned.index_bytes() << " (" << learned.segment_count() << " segments)" << endl;
+}
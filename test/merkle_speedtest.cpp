@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/merkle_map.hpp"
+
+using namespace std;
+
+// two replicas that differ in a handful of keys: an equality check and a
+// diff by walking both maps side by side, against merkle_map's digest and
+// diff; building the maps is not timed
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t changes = 100, rounds = 20;
+    vector<int> key, change;
+    for (size_t i = 0; i < count; ++i)
+        key.push_back(rand());
+    for (size_t i = 0; i < changes; ++i)
+        change.push_back(rand() % count);
+
+    sjtu::map<int, int> a, b;
+    sjtu::merkle_map<int, int> ma, mb;
+    for (size_t i = 0; i < count; ++i) {
+        a[key[i]] = b[key[i]] = i;
+        ma.insert_or_assign(key[i], i);
+        mb.insert_or_assign(key[i], i);
+    }
+    for (size_t i = 0; i < changes; ++i) {
+        if (i % 2) {
+            b[key[change[i]]] = -1;
+            mb.insert_or_assign(key[change[i]], -1);
+        }
+        else {
+            b.erase(b.find(key[change[i]]));
+            mb.erase(key[change[i]]);
+        }
+    }
+
+    clock_t start_time = clock();
+    long long s = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        s += a.size() == b.size();
+        sjtu::map<int, int>::const_iterator i = a.cbegin(), j = b.cbegin();
+        while (i != a.cend() || j != b.cend()) {
+            if (j == b.cend() || (i != a.cend() && i->first < j->first))
+                s += i++->first;
+            else if (i == a.cend() || j->first < i->first)
+                s += j++->first;
+            else {
+                if (i->second != j->second)
+                    s += i->first;
+                ++i, ++j;
+            }
+        }
+    }
+    clock_t end_time = clock();
+    cout << "map walk: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+
+    start_time = clock();
+    s = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        s += ma == mb;
+        s += ma.size() == mb.size();
+        sjtu::merkle_map<int, int>::diff(ma, mb, [&s](const sjtu::pair<const int, int> *x,
+                                                      const sjtu::pair<const int, int> *y) {
+            s += x ? x->first : y->first;
+        });
+    }
+    end_time = clock();
+    cout << "merkle_map: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+    return 0;
+}
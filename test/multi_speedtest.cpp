@@ -0,0 +1,80 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/set.hpp"
+#include "../src/multimap.hpp"
+
+using namespace std;
+
+struct Payload {
+    char bytes[64];
+};
+
+// map<Key, dummy> as a set against set, and a map of vectors against
+// multimap, on the same keys
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+    vector<int> A;
+    for (size_t i = 0; i < count; ++i)
+        A.push_back(rand() % count);
+
+    clock_t start_time = clock();
+    long long s = 0;
+    {
+        sjtu::map<int, Payload> test;
+        for (size_t i = 0; i < count; ++i)
+            test[A[i]];
+        for (size_t i = 0; i < count; ++i)
+            s += test.count(A[i] ^ 1);
+    }
+    clock_t end_time = clock();
+    cout << "map<int, Payload> as set: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+
+    start_time = clock();
+    s = 0;
+    {
+        sjtu::set<int> test;
+        for (size_t i = 0; i < count; ++i)
+            test.insert(A[i]);
+        for (size_t i = 0; i < count; ++i)
+            s += test.count(A[i] ^ 1);
+    }
+    end_time = clock();
+    cout << "set<int>: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+
+    start_time = clock();
+    s = 0;
+    {
+        sjtu::map<int, vector<int>> test;
+        for (size_t i = 0; i < count; ++i)
+            test[A[i] % (count / 8)].push_back(i);
+        for (size_t i = 0; i < count; ++i) {
+            sjtu::map<int, vector<int>>::iterator it = test.find(A[i] % (count / 8));
+            for (size_t j = 0; j < it->second.size(); ++j)
+                s += it->second[j];
+        }
+    }
+    end_time = clock();
+    cout << "map<int, vector<int>>: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+
+    start_time = clock();
+    s = 0;
+    {
+        sjtu::multimap<int, int> test;
+        for (size_t i = 0; i < count; ++i)
+            test.insert(sjtu::pair<const int, int>(A[i] % (count / 8), i));
+        for (size_t i = 0; i < count; ++i) {
+            sjtu::pair<sjtu::multimap<int, int>::iterator, sjtu::multimap<int, int>::iterator> range =
+                    test.equal_range(A[i] % (count / 8));
+            for (; range.first != range.second; ++range.first)
+                s += range.first->second;
+        }
+    }
+    end_time = clock();
+    cout << "multimap<int, int>: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+}
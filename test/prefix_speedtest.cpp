@@ -0,0 +1,56 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+
+using namespace std;
+
+// same order as std::less, but no key_normalizer matches it
+struct plain_less {
+    bool operator()(const string &a, const string &b) const {
+        return a < b;
+    }
+};
+
+template<class Map>
+double run(const vector<string> &key, const vector<string> &probe, long long &s) {
+    clock_t start_time = clock();
+    Map m;
+    for (size_t i = 0; i < key.size(); ++i)
+        m[key[i]] = i;
+    for (size_t i = 0; i < probe.size(); ++i)
+        s += m.count(probe[i]);
+    clock_t end_time = clock();
+    return 1.0 * (end_time - start_time) / CLOCKS_PER_SEC;
+}
+
+// random 24-letter keys, long enough to live on the heap, inserted and
+// then looked up (half of the probes hit): full comparisons at every
+// level, against the cached 8-byte prefixes
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    vector<string> key, probe;
+    for (size_t i = 0; i < count; ++i) {
+        string k(24, 'a');
+        for (size_t j = 0; j < k.size(); ++j)
+            k[j] = 'a' + rand() % 26;
+        key.push_back(k);
+    }
+    for (size_t i = 0; i < 4 * count; ++i) {
+        probe.push_back(key[rand() % count]);
+        if (i % 2)
+            probe.back()[23] = 'A';
+    }
+
+    long long s = 0;
+    double t = run<sjtu::map<string, int, plain_less>>(key, probe, s);
+    cout << "full keys: " << t << " (" << s << ")" << endl;
+    s = 0;
+    t = run<sjtu::map<string, int>>(key, probe, s);
+    cout << "cached prefixes: " << t << " (" << s << ")" << endl;
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+
+using namespace std;
+
+vector<int> A;
+long long s;
+
+double scan(sjtu::map<int, int> &test) {
+    clock_t start_time = clock();
+    for (int t = 0; t < 5; ++t)
+        for (sjtu::map<int, int>::iterator it = test.begin(); it != test.end(); ++it)
+            s += it->second;
+    return 1.0 * (clock() - start_time) / CLOCKS_PER_SEC;
+}
+
+double lookup(sjtu::map<int, int> &test) {
+    clock_t start_time = clock();
+    for (size_t i = 0; i < A.size(); ++i)
+        s += test.count(A[i]);
+    return 1.0 * (clock() - start_time) / CLOCKS_PER_SEC;
+}
+
+// usage: relayout_speedtest [entries]
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    sjtu::map<int, int> test;
+    // churn: keep about n keys alive while replacing them many times over
+    for (size_t i = 0; i < 4 * n; ++i) {
+        int a = rand() % (2 * n);
+        sjtu::map<int, int>::iterator it = test.find(a);
+        if (it == test.end())
+            test[a] = i;
+        else
+            test.erase(it);
+    }
+    for (size_t i = 0; i < n; ++i)
+        A.push_back(rand() % (2 * n));
+    cout << "churned: scan " << scan(test) << " lookup " << lookup(test) << endl;
+    const char *name[] = {"in-order", "dfs", "veb"};
+    for (int order = 0; order < 3; ++order) {
+        clock_t start_time = clock();
+        test.compact(sjtu::map_layout(order));
+        double cost = 1.0 * (clock() - start_time) / CLOCKS_PER_SEC;
+        cout << name[order] << ": compact " << cost << " scan " << scan(test)
+             << " lookup " << lookup(test) << endl;
+    }
+    clock_t start_time = clock();
+    test.compact_incremental(sjtu::VEB_LAYOUT);
+    int slices = 1;
+    while (!test.compact_step(10000))
+        ++slices;
+    cout << "veb in " << slices << " slices of 10000: "
+         << 1.0 * (clock() - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+}
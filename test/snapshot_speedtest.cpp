@@ -0,0 +1,31 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <ctime>
+#include "../src/map.hpp"
+
+using namespace std;
+
+sjtu::map<int, int> test;
+
+int main() {
+    for (int i = 0; i < 1000000; ++i) {
+        int a = rand(), b = rand() % 1000;
+        test[a] = b;
+    }
+    long long s1 = 0, s2 = 0;
+    clock_t start_time = clock();
+    for (int t = 0; t < 10; ++t)
+        for (sjtu::map<int, int>::const_iterator it = test.cbegin(); it != test.cend(); ++it)
+            s1 += it->second;
+    clock_t mid_time = clock();
+    sjtu::column_snapshot<int, int> snapshot = test.snapshot();
+    clock_t export_time = clock();
+    for (int t = 0; t < 10; ++t)
+        s2 += snapshot.sum<long long>(0, RAND_MAX);
+    clock_t end_time = clock();
+    cout << (s1 == s2) << endl;
+    cout << "iterator: " << 1.0 * (mid_time - start_time) / CLOCKS_PER_SEC << endl;
+    cout << "export: " << 1.0 * (export_time - mid_time) / CLOCKS_PER_SEC << endl;
+    cout << "snapshot: " << 1.0 * (end_time - export_time) / CLOCKS_PER_SEC << endl;
+}
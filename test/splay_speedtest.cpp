@@ -0,0 +1,67 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/splay_map.hpp"
+
+using namespace std;
+
+typedef sjtu::pair<const int, int> value_type;
+
+// the key of rank i + 1 is drawn with weight 1 / (i + 1)^s; ranks are a
+// fresh shuffle of the keys, so hot keys are neither neighbours nor the
+// first ones inserted (which would sit near the top of either tree)
+vector<int> zipf(size_t count, size_t draws, double s, const vector<int> &key) {
+    vector<double> cdf(count);
+    double sum = 0;
+    for (size_t i = 0; i < count; ++i)
+        cdf[i] = sum += pow(i + 1.0, -s);
+    vector<int> rank = key, res(draws);
+    shuffle(rank.begin(), rank.end(), mt19937(s * 1000));
+    for (size_t i = 0; i < draws; ++i) {
+        double u = sum * rand() / RAND_MAX;
+        size_t r = lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+        res[i] = rank[min(r, count - 1)];
+    }
+    return res;
+}
+
+template<class Map>
+void run(const char *name, const vector<int> &key, const vector<int> &probe) {
+    Map m;
+    for (size_t i = 0; i < key.size(); ++i)
+        m[key[i]] = i;
+    clock_t start_time = clock();
+    long long s = 0;
+    for (size_t i = 0; i < probe.size(); ++i)
+        s += m.at(probe[i]);
+    clock_t end_time = clock();
+    cout << name << ": " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+}
+
+// lookups of present keys drawn from Zipf distributions of rising skew
+// (s = 0 is uniform): the red-black map against splay_map with both
+// splay policies
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t lookups = 4 * count;
+    vector<int> key(count);
+    for (size_t i = 0; i < count; ++i)
+        key[i] = i * 7;
+    shuffle(key.begin(), key.end(), mt19937(1));
+
+    const double skew[] = {0, 0.8, 1.0, 1.2, 1.5};
+    for (double s : skew) {
+        vector<int> probe = zipf(count, lookups, s, key);
+        cout << "zipf s = " << s << endl;
+        run<sjtu::map<int, int>>("  map", key, probe);
+        run<sjtu::splay_map<int, int, less<int>, allocator<value_type>, sjtu::FULL_SPLAY>>("  splay", key, probe);
+        run<sjtu::splay_map<int, int, less<int>, allocator<value_type>, sjtu::SEMI_SPLAY>>("  semi-splay", key, probe);
+    }
+    return 0;
+}
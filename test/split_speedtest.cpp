@@ -0,0 +1,66 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+
+using namespace std;
+
+// two identical 256-byte payloads, only Cold asks for the split layout
+struct Big {
+    int a[64];
+};
+
+struct Cold {
+    int a[64];
+};
+
+struct Small {
+    int a[1];
+};
+
+namespace sjtu {
+    template<>
+    struct my_layout_traits<int, Cold> {
+        using split_values = my_true_type;
+    };
+}
+
+vector<int> A;
+
+template<class Value>
+void run(const char *name) {
+    typedef sjtu::map<int, Value> Map;
+    Map *test = new Map;
+    Value v;
+    memset(&v, 0, sizeof(v));
+    clock_t start_time = clock();
+    for (size_t i = 0; i < A.size(); ++i) {
+        v.a[0] = i;
+        test->insert(typename Map::value_type(A[i], v));
+    }
+    clock_t insert_time = clock();
+    long long s = 0;
+    for (int t = 0; t < 3; ++t)
+        for (size_t i = 0; i < A.size(); ++i) {
+            typename Map::iterator it = test->find(A[i] ^ t);
+            if (it != test->end())
+                s += it->second.a[0];
+        }
+    clock_t find_time = clock();
+    delete test;
+    cout << name << ": insert " << 1.0 * (insert_time - start_time) / CLOCKS_PER_SEC
+         << " lookup " << 1.0 * (find_time - insert_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+}
+
+// usage: split_speedtest [entries]
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    for (size_t i = 0; i < n; ++i)
+        A.push_back(rand());
+    run<Big>("inline values");
+    run<Cold>("split values");
+    run<Small>("keys only");
+}
@@ -0,0 +1,41 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/compact_map.hpp"
+#include "../src/static_map.hpp"
+
+using namespace std;
+
+const int SIZE = 32;
+vector<int> A;
+
+// the hot-loop pattern: build a small map, probe it, drop it
+template<class Map>
+void run(const char *name) {
+    clock_t start_time = clock();
+    long long s = 0;
+    for (size_t i = 0; i + SIZE <= A.size(); i += SIZE) {
+        Map test;
+        for (int j = 0; j < SIZE; ++j)
+            test[A[i + j] % 64] = j;
+        for (int j = 0; j < 4 * SIZE; ++j)
+            s += test.count(A[i + j % SIZE] % 64 + j % 2);
+    }
+    clock_t end_time = clock();
+    cout << name << ": " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << ")" << endl;
+}
+
+// usage: static_speedtest [rounds]
+int main(int argc, char **argv) {
+    size_t rounds = argc > 1 ? strtoull(argv[1], nullptr, 10) : 200000;
+    for (size_t i = 0; i < rounds * SIZE; ++i)
+        A.push_back(rand());
+    run<sjtu::map<int, int>>("map");
+    run<sjtu::compact_map<int, int>>("compact_map");
+    run<sjtu::static_map<int, int, SIZE>>("static_map");
+    cout << "sizeof static_map<int, int, " << SIZE << ">: " << sizeof(sjtu::static_map<int, int, SIZE>) << endl;
+}
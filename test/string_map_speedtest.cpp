@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/string_map.hpp"
+
+using namespace std;
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    ++allocations;
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+// text keys, half short and half past the small string buffer, looked up
+// as string_views into one buffer the way a parser would hold them: a
+// map<string, int> builds a string per lookup, string_map does not.
+// Allocations are counted over the inserts
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    string text;
+    vector<size_t> offset, length;
+    for (size_t i = 0; i < count; ++i) {
+        size_t len = i % 2 ? 8 + rand() % 8 : 24 + rand() % 16;
+        offset.push_back(text.size());
+        length.push_back(len);
+        for (size_t j = 0; j < len; ++j)
+            text.push_back('a' + rand() % 26);
+    }
+    vector<string_view> key, probe;
+    for (size_t i = 0; i < count; ++i)
+        key.push_back(string_view(text).substr(offset[i], length[i]));
+    for (size_t i = 0; i < 4 * count; ++i)
+        probe.push_back(key[rand() % count]);
+
+    clock_t start_time = clock();
+    long long s = 0;
+    size_t before = allocations, after;
+    {
+        sjtu::map<string, int> m;
+        for (size_t i = 0; i < count; ++i)
+            m[string(key[i])] = i;
+        after = allocations;
+        for (size_t i = 0; i < probe.size(); ++i)
+            s += m.at(string(probe[i]));
+    }
+    clock_t end_time = clock();
+    cout << "map<string, int>: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << "), "
+         << 1.0 * (after - before) / count << " allocations per entry" << endl;
+
+    start_time = clock();
+    s = 0;
+    before = allocations;
+    {
+        sjtu::string_map<int> m;
+        for (size_t i = 0; i < count; ++i)
+            m[key[i]] = i;
+        after = allocations;
+        for (size_t i = 0; i < probe.size(); ++i)
+            s += m.at(probe[i]);
+    }
+    end_time = clock();
+    cout << "string_map<int>: " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " (" << s << "), "
+         << 1.0 * (after - before) / count << " allocations per entry" << endl;
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ctime>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "../src/map.hpp"
+#include "../src/huge_page_allocator.hpp"
+
+using namespace std;
+
+typedef sjtu::map<int, int> SmallPageMap;
+typedef sjtu::map<int, int, std::less<int>,
+        sjtu::huge_page_allocator<sjtu::pair<const int, int>>> HugePageMap;
+
+vector<int> A;
+
+// dTLB load misses of this thread, -1 where perf events are unavailable
+int OpenCounter() {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// what the kernel actually backs with huge pages
+string HugePages() {
+    ifstream f("/proc/self/smaps_rollup");
+    string line;
+    while (getline(f, line))
+        if (line.compare(0, 14, "AnonHugePages:") == 0)
+            return line.substr(14);
+    return " n/a";
+}
+
+template<class Map>
+void run(const char *name, Map &test) {
+    for (size_t i = 0; i < A.size(); ++i)
+        test[A[i]] = i;
+    int fd = OpenCounter();
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    clock_t start_time = clock();
+    long long s = 0;
+    for (int t = 0; t < 3; ++t)
+        for (size_t i = 0; i < A.size(); ++i)
+            s += test.count(A[(i * 7919) % A.size()]);
+    clock_t end_time = clock();
+    long long misses = -1;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &misses, sizeof(misses)) != sizeof(misses))
+            misses = -1;
+        close(fd);
+    }
+    cout << name << ": lookup " << 1.0 * (end_time - start_time) / CLOCKS_PER_SEC << " dTLB misses ";
+    if (misses < 0)
+        cout << "n/a";
+    else
+        cout << misses;
+    cout << " AnonHugePages" << HugePages() << " (" << s << ")" << endl;
+}
+
+// usage: tlb_speedtest [entries]
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+    for (size_t i = 0; i < n; ++i)
+        A.push_back(rand());
+    {
+        SmallPageMap test;
+        run("4K pages", test);
+    }
+    {
+        HugePageMap test;
+        test.reserve(n);
+        run("huge pages", test);
+    }
+}
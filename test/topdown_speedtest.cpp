@@ -0,0 +1,55 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include "../src/map.hpp"
+#include "../src/topdown_map.hpp"
+
+using namespace std;
+
+vector<int> A;
+
+long resident() {
+    long pages = 0, rss = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%ld %ld", &pages, &rss) != 2)
+            rss = 0;
+        fclose(f);
+    }
+    return rss * 4096;
+}
+
+template<class Map>
+void run(const char *name) {
+    long before = resident();
+    clock_t start_time = clock();
+    Map *test = new Map;
+    for (size_t i = 0; i < A.size(); ++i)
+        (*test)[A[i]] = i;
+    clock_t insert_time = clock();
+    long bytes = resident() - before;
+    long long s = 0;
+    for (size_t i = 0; i < A.size(); ++i)
+        s += test->find(A[i])->second;
+    clock_t find_time = clock();
+    for (size_t i = 0; i < A.size(); ++i) {
+        typename Map::iterator it = test->find(A[i]);
+        if (it != test->end())
+            test->erase(it);
+    }
+    clock_t erase_time = clock();
+    delete test;
+    cout << name << ": insert " << 1.0 * (insert_time - start_time) / CLOCKS_PER_SEC
+         << " find " << 1.0 * (find_time - insert_time) / CLOCKS_PER_SEC
+         << " erase " << 1.0 * (erase_time - find_time) / CLOCKS_PER_SEC
+         << " bytes/entry " << 1.0 * bytes / A.size() << " (" << s % 10 << ")" << endl;
+}
+
+int main() {
+    for (int i = 0; i < 1000000; ++i)
+        A.push_back(rand());
+    run<sjtu::topdown_map<int, int>>("topdown_map");
+    run<sjtu::map<int, int>>("map");
+}